@@ -0,0 +1,98 @@
+#include "AssetLoader.h"
+#include "ObjectGL.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+StartupTimeline::StartupTimeline() {
+    this->startTime = chrono::steady_clock::now();
+}
+
+double StartupTimeline::now() const {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - this->startTime).count();
+}
+
+void StartupTimeline::record(const string& asset, const string& stage, double start, double end) {
+    TimelineEvent event = { asset, stage, ThreadPool::currentWorker(), start, end };
+    lock_guard<mutex> lock(this->eventsMutex);
+    this->events.push_back(event);
+}
+
+void StartupTimeline::print(double firstFrame) const {
+    lock_guard<mutex> lock(this->eventsMutex);
+    vector<TimelineEvent> sorted = this->events;
+    sort(sorted.begin(), sorted.end(), [](const TimelineEvent& a, const TimelineEvent& b) { return a.start < b.start; });
+
+    double work = 0; // the loading time if everything ran one after another
+    double loadingEnd = 0;
+    std::cout << "Startup timeline (ms):" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const TimelineEvent& event : sorted) {
+        std::cout << "  " << std::setw(8) << event.start << " - " << std::setw(8) << event.end
+            << "  " << (event.thread < 0 ? string("main    ") : "worker " + to_string(event.thread))
+            << "  " << std::left << std::setw(24) << event.asset << std::right << " " << event.stage
+            << " (" << event.end - event.start << ")" << std::endl;
+        work += event.end - event.start;
+        loadingEnd = max(loadingEnd, event.end);
+    }
+    std::cout << "  assets took " << work << " ms of work, loaded in " << loadingEnd << " ms";
+    if (work > loadingEnd) {
+        std::cout << " (" << work - loadingEnd << " ms saved by loading in parallel)";
+    }
+    std::cout << std::endl << "  time to first frame: " << firstFrame << " ms" << std::defaultfloat << std::endl;
+}
+
+TimelineScope::TimelineScope(const string& asset, const string& stage) {
+    this->asset = asset;
+    this->stage = stage;
+    this->start = AssetLoader::instance().timeline.now();
+}
+
+TimelineScope::~TimelineScope() {
+    StartupTimeline& timeline = AssetLoader::instance().timeline;
+    timeline.record(this->asset, this->stage, this->start, timeline.now());
+}
+
+AssetLoader& AssetLoader::instance() {
+    static AssetLoader loader;
+    return loader;
+}
+
+void AssetLoader::preloadModel(const string& inputfile) {
+    string file = ObjectGL::resolvePath(inputfile);
+    lock_guard<mutex> lock(this->modelsMutex);
+    if (this->models.find(file) != this->models.end()) {
+        return; // already loading
+    }
+    this->models[file] = this->pool.submit([file]() { return ObjectGL::loadModel(file); }).share();
+}
+
+shared_ptr<LoadedModel> AssetLoader::takeModel(const string& inputfile) {
+    shared_future<shared_ptr<LoadedModel>> model;
+    {
+        lock_guard<mutex> lock(this->modelsMutex);
+        map<string, shared_future<shared_ptr<LoadedModel>>>::iterator it = this->models.find(inputfile);
+        if (it == this->models.end()) {
+            return NULL;
+        }
+        model = it->second;
+        this->models.erase(it); // the decoded pixels are released once the model is uploaded
+    }
+    TimelineScope scope(inputfile, "wait");
+    return model.get();
+}
+
+future<void> AssetLoader::runAsync(const string& asset, const string& stage, function<void()> task) {
+    return this->pool.submit([asset, stage, task]() {
+        TimelineScope scope(asset, stage);
+        task();
+    });
+}
+
+void AssetLoader::firstFrame() {
+    if (this->firstFrameShown) {
+        return;
+    }
+    this->firstFrameShown = true;
+    this->timeline.print(this->timeline.now());
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <future>
+#include "ThreadPool.h"
+
+using namespace std;
+
+struct LoadedModel; // the cpu side of a model (defined in ObjectGL.h)
+
+// one step of loading an asset, in milliseconds since the startup began
+struct TimelineEvent {
+    string asset; // the asset name (file name)
+    string stage; // what was done (parse, decode, upload...)
+    int thread; // the pool worker that did it, -1 for the main thread
+    double start;
+    double end;
+};
+
+// records when every asset was loaded, to measure the time to the first frame
+class StartupTimeline {
+public:
+    StartupTimeline();
+    double now() const; // milliseconds since the timeline started
+    void record(const string& asset, const string& stage, double start, double end);
+    void print(double firstFrame) const; // log the events and how much the parallel loading saved
+
+private:
+    chrono::steady_clock::time_point startTime;
+    vector<TimelineEvent> events;
+    mutable mutex eventsMutex;
+};
+
+// records the time between its creation and destruction as a timeline event
+class TimelineScope {
+public:
+    TimelineScope(const string& asset, const string& stage);
+    ~TimelineScope();
+
+private:
+    string asset;
+    string stage;
+    double start;
+};
+
+// Loads the scene assets on worker threads during startup.
+// Models are parsed (or read from their mesh cache) and their textures decoded on the workers,
+// while the main thread creates the window. The opengl uploads stay on the main thread: ObjectGL
+// takes the preloaded model when it is created and only uploads it.
+class AssetLoader {
+public:
+    static AssetLoader& instance();
+
+    void preloadModel(const string& inputfile); // start loading a model on a worker
+    shared_ptr<LoadedModel> takeModel(const string& inputfile); // wait for a preloaded model, null if it was not preloaded
+    future<void> runAsync(const string& asset, const string& stage, function<void()> task); // run any loading task on a worker
+
+    void firstFrame(); // call after the first frame is shown, prints the startup timeline once
+    StartupTimeline timeline;
+
+private:
+    AssetLoader() = default;
+    ThreadPool pool;
+    map<string, shared_future<shared_ptr<LoadedModel>>> models; // preloaded models by file
+    mutex modelsMutex;
+    bool firstFrameShown = false;
+};
@@ -0,0 +1,259 @@
+#include "BubbleRenderer.h"
+#include "GLExtensions.h"
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+BubbleRenderer::~BubbleRenderer() {
+    if (this->texture != 0) {
+        glDeleteTextures(1, &this->texture);
+    }
+}
+
+BubbleRenderMode BubbleRenderer::drawnMode() const {
+    if (this->mode == BUBBLES_POINT_SPRITES && !hasPointSprites()) {
+        return BUBBLES_IMPOSTORS;
+    }
+    return this->mode;
+}
+
+void BubbleRenderer::draw(const ParticleSystem& particles, const glm::vec3& eye, const glm::vec3& target, float lag) {
+    if (particles.count() == 0) {
+        return;
+    }
+    this->lag = lag;
+
+    // the order the bubbles are drawn in
+    const vector<uint32_t>* order = &this->poolOrder;
+    if (this->sortByDepth) {
+        order = &this->depthSort.sort(particles, eye, glm::normalize(target - eye), lag);
+    }
+    else if (this->poolOrder.size() != particles.count()) {
+        this->poolOrder.resize(particles.count());
+        for (size_t i = 0; i < this->poolOrder.size(); i++) {
+            this->poolOrder[i] = (uint32_t)i;
+        }
+    }
+
+    glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT | GL_POINT_BIT);
+
+    // Enable blending to render transparent particles
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    switch (drawnMode()) {
+    case BUBBLES_SPHERES:
+        drawSpheres(particles, *order);
+        break;
+    case BUBBLES_IMPOSTORS:
+        drawImpostors(particles, *order, eye, target);
+        break;
+    case BUBBLES_POINT_SPRITES:
+        drawPointSprites(particles, *order, eye, target);
+        break;
+    }
+
+    glPopAttrib();
+}
+
+void BubbleRenderer::createTexture() {
+    // a sphere lit from the upper left front: faint body, fresnel like rim and a sharp highlight
+    vector<GLubyte> pixels(BUBBLE_TEXTURE_SIZE * BUBBLE_TEXTURE_SIZE * 4);
+    glm::vec3 light = glm::normalize(glm::vec3(-0.4f, 0.6f, 1.0f));
+    glm::vec3 half = glm::normalize(light + glm::vec3(0, 0, 1));
+    for (int y = 0; y < BUBBLE_TEXTURE_SIZE; y++) {
+        for (int x = 0; x < BUBBLE_TEXTURE_SIZE; x++) {
+            float u = (x + 0.5f) / BUBBLE_TEXTURE_SIZE * 2.0f - 1.0f;
+            float v = (y + 0.5f) / BUBBLE_TEXTURE_SIZE * 2.0f - 1.0f;
+            float r2 = u * u + v * v;
+            GLubyte* pixel = &pixels[(y * BUBBLE_TEXTURE_SIZE + x) * 4];
+            if (r2 >= 1.0f) {
+                pixel[0] = pixel[1] = pixel[2] = 255;
+                pixel[3] = 0;
+                continue;
+            }
+            glm::vec3 normal(u, v, sqrtf(1.0f - r2));
+            float diffuse = max(glm::dot(normal, light), 0.0f);
+            float specular = powf(max(glm::dot(normal, half), 0.0f), 60.0f);
+            float rim = powf(1.0f - normal.z, 3.0f);
+            float alpha = min(0.12f + 0.5f * rim + specular, 1.0f);
+            float shade = min(0.75f + 0.25f * diffuse + specular, 1.0f);
+            pixel[0] = pixel[1] = pixel[2] = (GLubyte)(shade * 255);
+            pixel[3] = (GLubyte)(alpha * 255);
+        }
+    }
+    glGenTextures(1, &this->texture);
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BUBBLE_TEXTURE_SIZE, BUBBLE_TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+void BubbleRenderer::createSphere() {
+    // unit sphere, the positions are also the normals
+    for (int ring = 0; ring <= BUBBLE_SPHERE_RINGS; ring++) {
+        float theta = ring * glm::pi<float>() / BUBBLE_SPHERE_RINGS;
+        for (int segment = 0; segment <= BUBBLE_SPHERE_SEGMENTS; segment++) {
+            float phi = segment * 2.0f * glm::pi<float>() / BUBBLE_SPHERE_SEGMENTS;
+            this->sphereVertices.push_back(sinf(theta) * cosf(phi));
+            this->sphereVertices.push_back(cosf(theta));
+            this->sphereVertices.push_back(sinf(theta) * sinf(phi));
+        }
+    }
+    const int row = BUBBLE_SPHERE_SEGMENTS + 1;
+    for (int ring = 0; ring < BUBBLE_SPHERE_RINGS; ring++) {
+        for (int segment = 0; segment < BUBBLE_SPHERE_SEGMENTS; segment++) {
+            GLushort a = (GLushort)(ring * row + segment), b = (GLushort)(a + row);
+            GLushort quad[6] = { a, (GLushort)(a + 1), b, b, (GLushort)(a + 1), (GLushort)(b + 1) };
+            this->sphereIndices.insert(this->sphereIndices.end(), quad, quad + 6);
+        }
+    }
+}
+
+void BubbleRenderer::drawSpheres(const ParticleSystem& particles, const vector<uint32_t>& order) {
+    if (this->sphereVertices.empty()) {
+        createSphere();
+    }
+    glEnable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+
+    // Set bubble-like material properties once for all the bubbles
+    GLfloat diffuse[] = { 1.0f, 1.0f, 1.0f, 0.3f }; // Transparent color
+    GLfloat specular[] = { 1.0f, 1.0f, 1.0f, 0.7f }; // Bright specular highlight
+    GLfloat shininess[] = { 100.0f }; // Shiny surface
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, this->sphereVertices.data());
+    glNormalPointer(GL_FLOAT, 0, this->sphereVertices.data());
+    for (uint32_t i : order) {
+        glm::vec3 center = position(particles, i);
+        glPushMatrix();
+        glTranslatef(center.x, center.y, center.z); // Move to particle's position
+        float radius = particles.size[i] * 0.5f;
+        glScalef(radius, radius, radius);
+        glDrawElements(GL_TRIANGLES, (GLsizei)this->sphereIndices.size(), GL_UNSIGNED_SHORT, this->sphereIndices.data());
+        glPopMatrix();
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+}
+
+void BubbleRenderer::drawImpostors(const ParticleSystem& particles, const vector<uint32_t>& order, const glm::vec3& eye, const glm::vec3& target) {
+    if (this->texture == 0) {
+        createTexture();
+    }
+    // every quad faces the camera plane
+    glm::vec3 forward = glm::normalize(target - eye);
+    glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0, 1, 0)));
+    glm::vec3 up = glm::cross(right, forward);
+
+    // x, y, z, u, v for the four corners of every bubble
+    const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+    size_t count = particles.count();
+    this->vertices.resize(count * 4 * 5);
+    GLfloat* vertex = this->vertices.data();
+    for (uint32_t i : order) {
+        float radius = particles.size[i] * 0.5f;
+        glm::vec3 center = position(particles, i);
+        glm::vec3 x = right * radius, y = up * radius;
+        for (const float* corner : corners) {
+            glm::vec3 position = center + x * corner[0] + y * corner[1];
+            vertex[0] = position.x;
+            vertex[1] = position.y;
+            vertex[2] = position.z;
+            vertex[3] = corner[0] * 0.5f + 0.5f;
+            vertex[4] = corner[1] * 0.5f + 0.5f;
+            vertex += 5;
+        }
+    }
+
+    // lit by the texture, transparent so they do not hide each other
+    glDisable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glDepthMask(GL_FALSE);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 5 * sizeof(GLfloat), this->vertices.data());
+    glTexCoordPointer(2, GL_FLOAT, 5 * sizeof(GLfloat), this->vertices.data() + 3);
+    glDrawArrays(GL_QUADS, 0, (GLsizei)(count * 4));
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BubbleRenderer::drawPointSprites(const ParticleSystem& particles, const vector<uint32_t>& order, const glm::vec3& eye, const glm::vec3& target) {
+    if (this->texture == 0) {
+        createTexture();
+    }
+    size_t count = particles.count();
+    this->vertices.resize(count * 3);
+    float meanSize = 0;
+    GLfloat* vertex = this->vertices.data();
+    for (uint32_t i : order) {
+        glm::vec3 center = position(particles, i);
+        vertex[0] = center.x;
+        vertex[1] = center.y;
+        vertex[2] = center.z;
+        vertex += 3;
+        meanSize += particles.size[i];
+    }
+    meanSize /= count;
+
+    // the attenuation measures the distance from the origin of eye space, but the scene keeps the camera in
+    // the projection: split the camera out of it into the modelview for the draw
+    GLfloat viewProjection[16];
+    GLint viewport[4];
+    glGetFloatv(GL_PROJECTION_MATRIX, viewProjection);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::make_mat4(viewProjection) * glm::inverse(view);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadMatrixf(glm::value_ptr(projection));
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glMultMatrixf(glm::value_ptr(view));
+
+    // the size in pixels is pointSize / distance: the diameter times the focal length in pixels
+    float focal = projection[1][1];
+    GLfloat attenuation[3] = { 0.0f, 0.0f, 1.0f };
+    pglPointParameterfv(GL_POINT_DISTANCE_ATTENUATION, attenuation);
+    pglPointParameterf(GL_POINT_SIZE_MIN, 1.0f);
+    glPointSize(meanSize * focal * viewport[3] * 0.5f);
+
+    glDisable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_POINT_SPRITE);
+    glTexEnvi(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
+    glDepthMask(GL_FALSE);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, this->vertices.data());
+    glDrawArrays(GL_POINTS, 0, (GLsizei)count);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    // the distance attenuation is not part of the point attributes in every driver
+    GLfloat noAttenuation[3] = { 1.0f, 0.0f, 0.0f };
+    pglPointParameterfv(GL_POINT_DISTANCE_ATTENUATION, noAttenuation);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
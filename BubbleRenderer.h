@@ -0,0 +1,66 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "ParticleDepthSort.h"
+#include "ParticleSystem.h"
+
+using namespace std;
+
+// how the bubbles are drawn
+enum BubbleRenderMode {
+    BUBBLES_SPHERES, // a shared low poly sphere per bubble (lit by the scene lights)
+    BUBBLES_IMPOSTORS, // a camera facing quad per bubble textured with a lit sphere, one draw call
+    BUBBLES_POINT_SPRITES // a point per bubble drawn as a sprite sized by distance, one draw call
+};
+
+const int BUBBLE_SPHERE_RINGS = 6; // the latitude bands of the low poly sphere
+const int BUBBLE_SPHERE_SEGMENTS = 10; // the longitude bands of the low poly sphere
+const int BUBBLE_TEXTURE_SIZE = 64; // the width and height of the impostor texture
+
+// Draws the live particles of a particle system as bubbles.
+// The impostor modes draw every bubble in a single call from a vertex array refilled each frame,
+// with a texture of a bubble lit from above (a translucent body, a bright rim and a highlight), so
+// they scale to hundreds of thousands of bubbles. The point sprites share one size (the mean size of
+// the bubbles) scaled by the distance, the quads keep the size of every bubble.
+// With sortByDepth the bubbles are drawn from the farthest to the nearest so the blending is right
+// where they overlap, otherwise in the order of the pool.
+class BubbleRenderer {
+public:
+    BubbleRenderer() = default;
+    BubbleRenderer(const BubbleRenderer&) = delete; // owns an opengl texture
+    BubbleRenderer& operator=(const BubbleRenderer&) = delete;
+    ~BubbleRenderer();
+
+    BubbleRenderMode mode = BUBBLES_IMPOSTORS;
+    bool sortByDepth = true;
+    ParticleDepthSort depthSort;
+
+    // draw the bubbles, eye and target are the camera position and the point it looks at,
+    // lag the seconds the frame is behind the simulation (the bubbles are moved back along their velocity)
+    void draw(const ParticleSystem& particles, const glm::vec3& eye, const glm::vec3& target, float lag = 0.0f);
+
+    BubbleRenderMode drawnMode() const; // the mode actually used (point sprites may not be supported)
+
+private:
+    GLuint texture = 0; // the lit bubble image of the impostors
+    vector<GLfloat> sphereVertices; // positions of the unit sphere, also its normals
+    vector<GLushort> sphereIndices;
+    vector<GLfloat> vertices; // the impostor vertices of the frame
+    vector<uint32_t> poolOrder; // the order of the pool, when not sorting
+    float lag = 0; // of the frame being drawn
+
+    // where a bubble is drawn, between its last two simulated positions
+    glm::vec3 position(const ParticleSystem& particles, uint32_t i) const {
+        return glm::vec3(particles.posX[i] - particles.velX[i] * this->lag, particles.posY[i] - particles.velY[i] * this->lag,
+            particles.posZ[i] - particles.velZ[i] * this->lag);
+    }
+
+    void createTexture();
+    void createSphere();
+    void drawSpheres(const ParticleSystem& particles, const vector<uint32_t>& order);
+    void drawImpostors(const ParticleSystem& particles, const vector<uint32_t>& order, const glm::vec3& eye, const glm::vec3& target);
+    void drawPointSprites(const ParticleSystem& particles, const vector<uint32_t>& order, const glm::vec3& eye, const glm::vec3& target);
+};
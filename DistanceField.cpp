@@ -0,0 +1,270 @@
+#include "DistanceField.h"
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char FIELD_MAGIC[4] = { 'R', 'G', 'L', 'D' };
+
+struct DistanceFieldHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key; // the hash of the triangles, walls and grid the field was baked from
+    int32_t cells[3];
+};
+
+// the distance between a point and a triangle, from its closest point (Ericson, Real-Time Collision Detection 5.1.5)
+static float triangleDistance(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) {
+        return glm::length(ap); // vertex a
+    }
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) {
+        return glm::length(bp); // vertex b
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        return glm::length(p - (a + ab * (d1 / (d1 - d3)))); // edge ab
+    }
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) {
+        return glm::length(cp); // vertex c
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        return glm::length(p - (a + ac * (d2 / (d2 - d6)))); // edge ac
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+        return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))); // edge bc
+    }
+    float denominator = 1.0f / (va + vb + vc); // inside the face (NaN for a degenerate triangle, which is skipped)
+    return glm::length(p - (a + ab * (vb * denominator) + ac * (vc * denominator)));
+}
+
+DistanceField::DistanceField(const glm::vec3& lower, const glm::vec3& upper, float cellSize) {
+    this->lower = lower;
+    this->cellSize = cellSize;
+    for (int axis = 0; axis < 3; axis++) {
+        this->cells[axis] = max((int)ceil((upper[axis] - lower[axis]) / cellSize), 2);
+    }
+}
+
+void DistanceField::addObject(const ObjectGL& object) {
+    object.worldTriangles(this->corners);
+}
+
+void DistanceField::addPlane(const glm::vec3& point, const glm::vec3& normal) {
+    glm::vec3 unit = glm::normalize(normal);
+    this->planes.push_back(glm::vec4(unit, -glm::dot(unit, point)));
+}
+
+ParticleField DistanceField::particleField(ParticleCollision response, float restitution) const {
+    ParticleField field = {
+        this->distances.empty() ? NULL : this->distances.data(),
+        { this->cells[0], this->cells[1], this->cells[2] },
+        { this->lower.x, this->lower.y, this->lower.z },
+        this->cellSize,
+        response,
+        restitution
+    };
+    return field;
+}
+
+void DistanceField::build(const string& cacheFile) {
+    double start = FrameProfiler::now();
+    uint64_t key = this->key();
+    this->fromCache = load(cacheFile, key);
+    if (!this->fromCache) {
+        bake();
+        save(cacheFile, key);
+    }
+    this->buildMs = FrameProfiler::now() - start;
+    cout << "Distance field: " << this->cells[0] << "x" << this->cells[1] << "x" << this->cells[2] << " cells, "
+        << triangleCount() << " triangles, " << (this->fromCache ? "loaded" : "baked") << " in " << this->buildMs << " ms" << endl;
+}
+
+uint64_t DistanceField::key() const {
+    // FNV-1a over the raw bytes
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    int band = DISTANCE_FIELD_BAND;
+    add(this->cells, sizeof(this->cells));
+    add(&this->lower, sizeof(this->lower));
+    add(&this->cellSize, sizeof(this->cellSize));
+    add(&band, sizeof(band));
+    add(this->corners.data(), this->corners.size() * sizeof(glm::vec3));
+    add(this->planes.data(), this->planes.size() * sizeof(glm::vec4));
+    return hash;
+}
+
+bool DistanceField::load(const string& cacheFile, uint64_t key) {
+    ifstream file(cacheFile, ios::binary);
+    DistanceFieldHeader header;
+    if (!file.read((char*)&header, sizeof(header))) {
+        return false;
+    }
+    if (memcmp(header.magic, FIELD_MAGIC, sizeof(FIELD_MAGIC)) != 0 || header.version != DISTANCE_FIELD_VERSION ||
+        header.key != key || memcmp(header.cells, this->cells, sizeof(this->cells)) != 0) {
+        cout << "Distance field cache " << cacheFile << " is out of date, baking" << endl;
+        return false;
+    }
+    this->distances.resize((size_t)this->cells[0] * this->cells[1] * this->cells[2]);
+    if (!file.read((char*)this->distances.data(), this->distances.size() * sizeof(float))) {
+        this->distances.clear();
+        return false;
+    }
+    return true;
+}
+
+bool DistanceField::save(const string& cacheFile, uint64_t key) const {
+    DistanceFieldHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FIELD_MAGIC, sizeof(FIELD_MAGIC));
+    header.version = DISTANCE_FIELD_VERSION;
+    header.key = key;
+    memcpy(header.cells, this->cells, sizeof(this->cells));
+    ofstream file(cacheFile, ios::binary | ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)this->distances.data(), this->distances.size() * sizeof(float));
+    return file.good();
+}
+
+void DistanceField::bake() {
+    const float far = (this->cells[0] + this->cells[1] + this->cells[2]) * this->cellSize; // more than any distance in the grid
+    this->distances.assign((size_t)this->cells[0] * this->cells[1] * this->cells[2], far);
+
+    // the exact distance in a band of cells around every triangle
+    float band = DISTANCE_FIELD_BAND * this->cellSize;
+    for (size_t t = 0; t + 2 < this->corners.size(); t += 3) {
+        const glm::vec3& a = this->corners[t];
+        const glm::vec3& b = this->corners[t + 1];
+        const glm::vec3& c = this->corners[t + 2];
+        glm::vec3 from = (glm::min(glm::min(a, b), c) - band - this->lower) / this->cellSize - 0.5f;
+        glm::vec3 to = (glm::max(glm::max(a, b), c) + band - this->lower) / this->cellSize - 0.5f;
+        int first[3], last[3];
+        for (int axis = 0; axis < 3; axis++) {
+            first[axis] = max((int)ceil(from[axis]), 0);
+            last[axis] = min((int)floor(to[axis]), this->cells[axis] - 1);
+        }
+        for (int z = first[2]; z <= last[2]; z++) {
+            for (int y = first[1]; y <= last[1]; y++) {
+                for (int x = first[0]; x <= last[0]; x++) {
+                    float distance = triangleDistance(cellCenter(x, y, z), a, b, c);
+                    float& cell = this->distances[cellIndex(x, y, z)];
+                    if (distance < cell) {
+                        cell = distance;
+                    }
+                }
+            }
+        }
+    }
+    sweep();
+
+    // the walls are exact everywhere
+    for (const glm::vec4& plane : this->planes) {
+        for (int z = 0; z < this->cells[2]; z++) {
+            for (int y = 0; y < this->cells[1]; y++) {
+                for (int x = 0; x < this->cells[0]; x++) {
+                    float& cell = this->distances[cellIndex(x, y, z)];
+                    cell = min(cell, glm::dot(glm::vec3(plane), cellCenter(x, y, z)) + plane.w);
+                }
+            }
+        }
+    }
+    markInside();
+}
+
+void DistanceField::sweep() {
+    // the 13 neighbours before a cell in the raster order, and their distance
+    int offsets[13][3];
+    float lengths[13];
+    int count = 0;
+    for (int dz = -1; dz <= 0; dz++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0))) {
+                    continue;
+                }
+                offsets[count][0] = dx;
+                offsets[count][1] = dy;
+                offsets[count][2] = dz;
+                lengths[count] = sqrtf((float)(dx * dx + dy * dy + dz * dz)) * this->cellSize;
+                count++;
+            }
+        }
+    }
+
+    // forward from the neighbours before, then backward from the neighbours after
+    for (int direction = 1; direction >= -1; direction -= 2) {
+        int begin[3], end[3];
+        for (int axis = 0; axis < 3; axis++) {
+            begin[axis] = direction > 0 ? 0 : this->cells[axis] - 1;
+            end[axis] = direction > 0 ? this->cells[axis] : -1;
+        }
+        for (int z = begin[2]; z != end[2]; z += direction) {
+            for (int y = begin[1]; y != end[1]; y += direction) {
+                for (int x = begin[0]; x != end[0]; x += direction) {
+                    float& cell = this->distances[cellIndex(x, y, z)];
+                    for (int n = 0; n < count; n++) {
+                        int nx = x + offsets[n][0] * direction, ny = y + offsets[n][1] * direction, nz = z + offsets[n][2] * direction;
+                        if (nx < 0 || ny < 0 || nz < 0 || nx >= this->cells[0] || ny >= this->cells[1] || nz >= this->cells[2]) {
+                            continue;
+                        }
+                        cell = min(cell, this->distances[cellIndex(nx, ny, nz)] + lengths[n]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void DistanceField::markInside() {
+    // a surface between two neighbour centers is less than half a cell from one of them,
+    // so the air spreads through the cells farther than that from every surface
+    const float clear = this->cellSize * 0.5f;
+    vector<char> air(this->distances.size(), 0);
+    vector<int> open;
+    int top = this->cells[1] - 1;
+    for (int z = 0; z < this->cells[2]; z++) {
+        for (int x = 0; x < this->cells[0]; x++) {
+            size_t cell = cellIndex(x, top, z);
+            if (this->distances[cell] > clear) {
+                air[cell] = 1;
+                open.push_back((int)cell);
+            }
+        }
+    }
+    const int steps[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    while (!open.empty()) {
+        int cell = open.back();
+        open.pop_back();
+        int x = cell % this->cells[0], y = (cell / this->cells[0]) % this->cells[1], z = cell / (this->cells[0] * this->cells[1]);
+        for (const int* step : steps) {
+            int nx = x + step[0], ny = y + step[1], nz = z + step[2];
+            if (nx < 0 || ny < 0 || nz < 0 || nx >= this->cells[0] || ny >= this->cells[1] || nz >= this->cells[2]) {
+                continue;
+            }
+            size_t neighbour = cellIndex(nx, ny, nz);
+            if (!air[neighbour] && this->distances[neighbour] > clear) {
+                air[neighbour] = 1;
+                open.push_back((int)neighbour);
+            }
+        }
+    }
+    for (size_t cell = 0; cell < this->distances.size(); cell++) {
+        if (!air[cell] && this->distances[cell] > clear) {
+            this->distances[cell] = -this->distances[cell];
+        }
+    }
+}
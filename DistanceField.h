@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ObjectGL.h"
+#include "ParticleKernels.h"
+
+using namespace std;
+
+const float DISTANCE_FIELD_CELL = 0.25f; // the side of a cell, in world units
+const int DISTANCE_FIELD_BAND = 2; // the cells around every triangle where the exact distance is computed
+const unsigned int DISTANCE_FIELD_VERSION = 1; // bump whenever the cache layout or the bake changes
+const string DISTANCE_FIELD_EXTENSION = ".distancefield"; // the cache file of a baked field
+
+// A coarse signed distance field of the static scene, for the particles to collide with.
+// The triangles of the static objects (at their placement when the field is built) and the walls are
+// baked once into a grid of distances at the cell centers: exact point to triangle distances in a band
+// of cells around every triangle, then two chamfer sweeps carry the distances to the rest of the grid.
+// The air is flooded from the top of the grid; the cells it can not reach are inside an object and get
+// a negative distance. The bake is written next to the objects, keyed by a hash of the triangles, walls
+// and grid, and later launches load it as long as nothing moved.
+// The particles sample it with a trilinear lookup, so their cost does not depend on the triangles.
+class DistanceField {
+public:
+    DistanceField(const glm::vec3& lower, const glm::vec3& upper, float cellSize = DISTANCE_FIELD_CELL);
+
+    void addObject(const ObjectGL& object); // the triangles of an object at its current placement
+    void addPlane(const glm::vec3& point, const glm::vec3& normal); // a wall through a point, its normal toward the air
+    void build(const string& cacheFile); // load the cache if it was baked from the same scene, otherwise bake and write it
+
+    ParticleField particleField(ParticleCollision response, float restitution) const; // the field for the particle update
+    size_t triangleCount() const { return this->corners.size() / 3; }
+    bool fromCache = false; // the last build loaded the cache
+    double buildMs = 0; // how long the last build took
+
+private:
+    glm::vec3 lower; // the corner of the first cell
+    int cells[3]; // along x, y and z
+    float cellSize;
+    vector<glm::vec3> corners; // three per triangle, in world space
+    vector<glm::vec4> planes; // normal and offset: the distance of p is dot(normal, p) + w
+    vector<float> distances; // at the cell centers, x varying fastest
+
+    size_t cellIndex(int x, int y, int z) const { return ((size_t)z * this->cells[1] + y) * this->cells[0] + x; }
+    glm::vec3 cellCenter(int x, int y, int z) const { return this->lower + (glm::vec3(x, y, z) + 0.5f) * this->cellSize; }
+    uint64_t key() const; // a hash of everything the bake depends on
+    bool load(const string& cacheFile, uint64_t key);
+    bool save(const string& cacheFile, uint64_t key) const;
+    void bake();
+    void sweep(); // carry the distances from the band to the far cells
+    void markInside(); // negate the distances of the cells the air does not reach
+};
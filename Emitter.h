@@ -0,0 +1,118 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include "Particle.h"
+#include "Random.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief A source of particles, such as a bubbles machine.
+ *
+ * The emitter spawns particles at a steady rate wherever it is: the fraction of a particle left
+ * over by a step is carried to the next one, so the rate does not depend on the step length.
+ * The particles start in a box around the emitter, with a velocity, size and life picked
+ * uniformly between a minimum and a maximum, drawn from the emitter's own random stream so the
+ * spawns of a seed are the same whatever else draws random numbers.
+ */
+class Emitter {
+public:
+    glm::vec3 position = glm::vec3(0.0f); ///< The center of the spawn box
+    glm::vec3 extent = glm::vec3(0.0f); ///< Half the size of the spawn box
+    float rate = 300.0f; ///< Particles spawned per second at full budget
+    glm::vec3 minVelocity = glm::vec3(0.0f); ///< The lowest starting velocity on each axis
+    glm::vec3 maxVelocity = glm::vec3(0.0f); ///< The highest starting velocity on each axis
+    float minLife = 10.0f, maxLife = 10.0f; ///< The range of the life span, in seconds
+    float minSize = 0.2f, maxSize = 0.3f; ///< The range of the particle sizes
+    glm::vec4 color = glm::vec4(1.0f); ///< The color of the particles, including alpha
+    bool enabled = true; ///< Whether the emitter spawns
+    size_t spawned = 0; ///< Particles spawned since the start
+    RandomStream random; ///< The stream the spawns are drawn from (see Random::stream)
+
+    /**
+     * @brief The number of particles to spawn for a step, carrying the fraction left over.
+     *
+     * @param deltaTime The length of the step, in seconds.
+     * @param scale The fraction of the rate allowed by the budget.
+     */
+    int due(float deltaTime, float scale) {
+        if (!enabled) {
+            return 0;
+        }
+        carry += rate * scale * deltaTime;
+        int count = (int)carry;
+        carry -= count;
+        return count;
+    }
+
+    /**
+     * @brief New particles of this emitter.
+     *
+     * The random values of the whole batch are drawn at once, then mapped to the ranges.
+     *
+     * @param count The number of particles to spawn.
+     * @param particles Receives the particles (cleared first).
+     */
+    void spawn(int count, std::vector<Particle>& particles) {
+        particles.clear();
+        if (count <= 0) {
+            return;
+        }
+        unit.resize((size_t)count * EMITTER_RANDOMS);
+        random.fill(unit.data(), unit.size());
+        for (int n = 0; n < count; n++) {
+            const float* u = &unit[(size_t)n * EMITTER_RANDOMS];
+            glm::vec3 offset(between(-extent.x, extent.x, u[0]), between(-extent.y, extent.y, u[1]), between(-extent.z, extent.z, u[2]));
+            glm::vec3 velocity(between(minVelocity.x, maxVelocity.x, u[3]), between(minVelocity.y, maxVelocity.y, u[4]),
+                between(minVelocity.z, maxVelocity.z, u[5]));
+            particles.push_back(Particle(position + offset, velocity, color, between(minLife, maxLife, u[6]), between(minSize, maxSize, u[7])));
+        }
+        spawned += count;
+    }
+
+private:
+    static const int EMITTER_RANDOMS = 8; ///< The random values a particle takes: offset, velocity, life and size
+    float carry = 0.0f; ///< The fraction of a particle not spawned yet
+    std::vector<float> unit; ///< The random values of the batch being spawned, in [0, 1)
+
+    /**
+     * @brief The value a fraction of the way between two bounds.
+     */
+    static float between(float low, float high, float fraction) {
+        return low + (high - low) * fraction;
+    }
+};
+
+/**
+ * @brief Scales the spawn rate of a particle system to keep its frame time under a target.
+ *
+ * The cost of the particles grows with their number, so when the particles took longer than the
+ * target the rate is scaled by target / time, and it goes back up the same way when there is room.
+ * The change is smoothed over several frames so the noise of a single frame does not make it swing.
+ */
+class ParticleBudget {
+public:
+    float targetMs = 2.0f; ///< The particle time allowed per frame, in milliseconds (0 disables the governor)
+    float minScale = 0.05f; ///< The lowest fraction of the rate, so the emitters never stop completely
+    float smoothing = 0.1f; ///< The weight of the newest frame
+    float scale = 1.0f; ///< The fraction of the rate the emitters spawn
+
+    /**
+     * @brief Adjust the scale to the time the particles took in the last frame.
+     *
+     * @param ms The simulation and drawing time of the particles, in milliseconds.
+     */
+    void govern(double ms) {
+        if (targetMs <= 0.0f) {
+            scale = 1.0f;
+            return;
+        }
+        if (ms <= 0.0) {
+            return;
+        }
+        float wanted = std::min(std::max((float)(scale * targetMs / ms), minScale), 1.0f);
+        scale += (wanted - scale) * smoothing;
+    }
+};
+
+#endif // EMITTER_H
@@ -13,9 +13,6 @@ Floor::Floor(GLfloat xMin, GLfloat xMax, GLfloat yMin, GLfloat yMax, int rows, i
     this->rows = rows * 3; // Increase rows by a factor of 3 for more tiles
     this->columns = columns * 3; // Increase columns by a factor of 3 for more tiles
 
-    // Initialize random seed for color generation
-    initRandomSeed();
-
     // Generate random colors for each tile
     generateTileColors();
 }
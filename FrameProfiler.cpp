@@ -0,0 +1,43 @@
+#include "FrameProfiler.h"
+
+FrameProfiler& FrameProfiler::instance() {
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+double FrameProfiler::now() {
+    static const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void FrameProfiler::beginFrame() {
+    for (pair<const string, ProfileSection>& entry : this->sectionTimes) {
+        ProfileSection& section = entry.second;
+        section.lastMs = section.currentMs;
+        section.averageMs += (section.lastMs - section.averageMs) * PROFILE_SMOOTHING;
+        section.currentMs = 0;
+    }
+}
+
+void FrameProfiler::add(const string& section, double ms) {
+    this->sectionTimes[section].currentMs += ms;
+}
+
+double FrameProfiler::lastMs(const string& section) const {
+    map<string, ProfileSection>::const_iterator it = this->sectionTimes.find(section);
+    return it != this->sectionTimes.end() ? it->second.lastMs : 0.0;
+}
+
+double FrameProfiler::averageMs(const string& section) const {
+    map<string, ProfileSection>::const_iterator it = this->sectionTimes.find(section);
+    return it != this->sectionTimes.end() ? it->second.averageMs : 0.0;
+}
+
+ProfileScope::ProfileScope(const string& section) {
+    this->section = section;
+    this->start = FrameProfiler::now();
+}
+
+ProfileScope::~ProfileScope() {
+    FrameProfiler::instance().add(this->section, FrameProfiler::now() - this->start);
+}
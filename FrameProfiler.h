@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <chrono>
+
+using namespace std;
+
+// the time spent in one part of the frame
+struct ProfileSection {
+    double lastMs = 0; // in the last complete frame
+    double averageMs = 0; // smoothed over the recent frames
+    double currentMs = 0; // accumulated in the frame in progress
+};
+
+const double PROFILE_SMOOTHING = 0.1; // the weight of the newest frame in the averages
+
+// Times the named parts of every frame on the main thread, for the debug window and the budget governors.
+// A section may be timed several times in a frame, its times add up.
+class FrameProfiler {
+public:
+    static FrameProfiler& instance();
+    static double now(); // milliseconds on a steady clock
+
+    void beginFrame(); // close the frame in progress and start a new one
+    void add(const string& section, double ms); // add time to a section of the frame in progress
+    double lastMs(const string& section) const; // the time of a section in the last complete frame
+    double averageMs(const string& section) const; // the smoothed time of a section
+    const map<string, ProfileSection>& sections() const { return this->sectionTimes; }
+
+private:
+    FrameProfiler() = default;
+    map<string, ProfileSection> sectionTimes;
+};
+
+// adds the time between its creation and destruction to a section of the frame
+class ProfileScope {
+public:
+    ProfileScope(const string& section);
+    ~ProfileScope();
+
+private:
+    string section;
+    double start;
+};
@@ -0,0 +1,58 @@
+#include "Frustum.h"
+#include <glm/gtc/type_ptr.hpp>
+
+glm::mat4 Frustum::currentClipMatrix() {
+    GLfloat modelview[16], projection[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection); // the camera is set in the projection matrix
+    return glm::make_mat4(projection) * glm::make_mat4(modelview);
+}
+
+Frustum Frustum::fromClipMatrix(const glm::mat4& clip) {
+    // a point is inside when -w <= x, y, z <= w in clip space (Gribb and Hartmann)
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++) {
+        rows[r] = glm::vec4(clip[0][r], clip[1][r], clip[2][r], clip[3][r]);
+    }
+    Frustum frustum;
+    for (int axis = 0; axis < 3; axis++) {
+        frustum.planes[axis * 2] = rows[3] + rows[axis];
+        frustum.planes[axis * 2 + 1] = rows[3] - rows[axis];
+    }
+    for (glm::vec4& plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) {
+            plane = plane * (1.0f / length); // unit normals, so the plane distance is a real distance
+        }
+    }
+    return frustum;
+}
+
+Frustum Frustum::current() {
+    return fromClipMatrix(currentClipMatrix());
+}
+
+bool Frustum::containsSphere(const glm::vec3& center, float radius) const {
+    for (const glm::vec4& plane : this->planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::containsBox(const glm::vec3& lower, const glm::vec3& upper) const {
+    for (const glm::vec4& plane : this->planes) {
+        // the corner furthest along the plane normal
+        glm::vec3 corner(plane.x >= 0 ? upper.x : lower.x, plane.y >= 0 ? upper.y : lower.y, plane.z >= 0 ? upper.z : lower.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::contains(const MeshBounds& bounds) const {
+    return containsSphere(glm::make_vec3(bounds.center), bounds.radius) &&
+        containsBox(glm::make_vec3(bounds.lower), glm::make_vec3(bounds.upper));
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <glm/glm.hpp>
+#include "Mesh.h"
+
+// the view volume as six planes (left, right, bottom, top, near, far) with normals pointing inside
+class Frustum {
+public:
+    glm::vec4 planes[6];
+
+    static glm::mat4 currentClipMatrix(); // projection (with the camera) times modelview of the current opengl state
+    static Frustum fromClipMatrix(const glm::mat4& clip); // the planes are in the space the clip matrix transforms from
+    static Frustum current(); // the frustum in the object space of the current modelview matrix
+
+    bool containsSphere(const glm::vec3& center, float radius) const; // false only if the sphere is fully outside
+    bool containsBox(const glm::vec3& lower, const glm::vec3& upper) const; // false only if the box is fully outside
+    bool contains(const MeshBounds& bounds) const; // sphere test first, then the box
+};
+
+// how many objects and shapes were drawn and culled in a frame
+struct CullStats {
+    int objectsDrawn = 0;
+    int objectsCulled = 0;
+    int shapesDrawn = 0;
+    int shapesCulled = 0;
+};
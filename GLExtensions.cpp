@@ -0,0 +1,80 @@
+#include "GLExtensions.h"
+#include <GL/freeglut.h>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+PFN_glGenBuffers pglGenBuffers = NULL;
+PFN_glDeleteBuffers pglDeleteBuffers = NULL;
+PFN_glBindBuffer pglBindBuffer = NULL;
+PFN_glBufferData pglBufferData = NULL;
+PFN_glMapBuffer pglMapBuffer = NULL;
+PFN_glUnmapBuffer pglUnmapBuffer = NULL;
+PFN_glPointParameterf pglPointParameterf = NULL;
+PFN_glPointParameterfv pglPointParameterfv = NULL;
+
+static bool extensionsLoaded = false;
+static bool pixelBuffersSupported = false;
+static bool pointSpritesSupported = false;
+
+// look up an entry point, falling back to the ARB suffixed name used by older drivers
+static GLUTproc getProc(const char* name, const char* arbName) {
+    GLUTproc proc = glutGetProcAddress(name);
+    if (proc == NULL) {
+        proc = glutGetProcAddress(arbName);
+    }
+    return proc;
+}
+
+bool loadGLExtensions() {
+    if (extensionsLoaded) {
+        return hasBufferObjects();
+    }
+    extensionsLoaded = true;
+
+    pglGenBuffers = (PFN_glGenBuffers)getProc("glGenBuffers", "glGenBuffersARB");
+    pglDeleteBuffers = (PFN_glDeleteBuffers)getProc("glDeleteBuffers", "glDeleteBuffersARB");
+    pglBindBuffer = (PFN_glBindBuffer)getProc("glBindBuffer", "glBindBufferARB");
+    pglBufferData = (PFN_glBufferData)getProc("glBufferData", "glBufferDataARB");
+    pglMapBuffer = (PFN_glMapBuffer)getProc("glMapBuffer", "glMapBufferARB");
+    pglUnmapBuffer = (PFN_glUnmapBuffer)getProc("glUnmapBuffer", "glUnmapBufferARB");
+    pglPointParameterf = (PFN_glPointParameterf)getProc("glPointParameterf", "glPointParameterfARB");
+    pglPointParameterfv = (PFN_glPointParameterfv)getProc("glPointParameterfv", "glPointParameterfvARB");
+
+    // pixel buffers are core in OpenGL 2.1, older drivers may expose them as an extension
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    int major = 0, minor = 0;
+    if (version != NULL) {
+        sscanf(version, "%d.%d", &major, &minor);
+    }
+    bool pixelBufferVersion = major > 2 || (major == 2 && minor >= 1);
+    bool pixelBufferExtension = extensions != NULL && strstr(extensions, "GL_ARB_pixel_buffer_object") != NULL;
+    pixelBuffersSupported = hasBufferObjects() && pglMapBuffer != NULL && pglUnmapBuffer != NULL
+        && (pixelBufferVersion || pixelBufferExtension);
+
+    bool pointSpriteVersion = major >= 2;
+    bool pointSpriteExtension = extensions != NULL && strstr(extensions, "GL_ARB_point_sprite") != NULL;
+    pointSpritesSupported = pglPointParameterf != NULL && pglPointParameterfv != NULL
+        && (pointSpriteVersion || pointSpriteExtension);
+
+    if (!hasBufferObjects()) {
+        std::cerr << "Buffer objects are not supported, falling back to client side vertex arrays" << std::endl;
+    }
+    if (!pixelBuffersSupported) {
+        std::cerr << "Pixel buffer objects are not supported, textures are uploaded from client memory" << std::endl;
+    }
+    return hasBufferObjects();
+}
+
+bool hasBufferObjects() {
+    return pglGenBuffers != NULL && pglDeleteBuffers != NULL && pglBindBuffer != NULL && pglBufferData != NULL;
+}
+
+bool hasPixelBuffers() {
+    return pixelBuffersSupported;
+}
+
+bool hasPointSprites() {
+    return pointSpritesSupported;
+}
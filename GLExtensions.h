@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <cstddef>
+
+// The Windows SDK only ships OpenGL 1.1 headers, so the buffer object entry points
+// (OpenGL 1.5) are declared here and loaded at runtime through freeglut.
+// Pixel buffer objects (OpenGL 2.1 / ARB_pixel_buffer_object) reuse the same entry points.
+// Point sprites (OpenGL 2.0 / ARB_point_sprite) need the point parameters of OpenGL 1.4.
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_POINT_SPRITE
+#define GL_POINT_SPRITE 0x8861
+#endif
+#ifndef GL_COORD_REPLACE
+#define GL_COORD_REPLACE 0x8862
+#endif
+#ifndef GL_POINT_SIZE_MIN
+#define GL_POINT_SIZE_MIN 0x8126
+#endif
+#ifndef GL_POINT_SIZE_MAX
+#define GL_POINT_SIZE_MAX 0x8127
+#endif
+#ifndef GL_POINT_DISTANCE_ATTENUATION
+#define GL_POINT_DISTANCE_ATTENUATION 0x8129
+#endif
+
+typedef void (APIENTRY* PFN_glGenBuffers)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY* PFN_glDeleteBuffers)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY* PFN_glBindBuffer)(GLenum target, GLuint buffer);
+typedef void (APIENTRY* PFN_glBufferData)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+typedef void* (APIENTRY* PFN_glMapBuffer)(GLenum target, GLenum access);
+typedef GLboolean (APIENTRY* PFN_glUnmapBuffer)(GLenum target);
+typedef void (APIENTRY* PFN_glPointParameterf)(GLenum pname, GLfloat param);
+typedef void (APIENTRY* PFN_glPointParameterfv)(GLenum pname, const GLfloat* params);
+
+extern PFN_glGenBuffers pglGenBuffers;
+extern PFN_glDeleteBuffers pglDeleteBuffers;
+extern PFN_glBindBuffer pglBindBuffer;
+extern PFN_glBufferData pglBufferData;
+extern PFN_glMapBuffer pglMapBuffer;
+extern PFN_glUnmapBuffer pglUnmapBuffer;
+extern PFN_glPointParameterf pglPointParameterf;
+extern PFN_glPointParameterfv pglPointParameterfv;
+
+bool loadGLExtensions(); // load the extension entry points (needs a current GL context), safe to call more than once
+bool hasBufferObjects(); // true if vertex/index buffer objects are available
+bool hasPixelBuffers(); // true if textures can be uploaded from pixel buffer objects
+bool hasPointSprites(); // true if points can be drawn as textured sprites sized by distance
+
+// convert a byte offset into the pointer argument gl*Pointer / glDrawElements expect
+inline const GLvoid* bufferOffset(size_t offset) {
+    return reinterpret_cast<const GLvoid*>(offset);
+}
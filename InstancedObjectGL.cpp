@@ -0,0 +1,153 @@
+#include "InstancedObjectGL.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+
+InstancedObjectGL::InstancedObjectGL(string inputfile, glm::vec3 upVector)
+    : ObjectGL(inputfile, 0, 0, 0, 1.0f, upVector) {
+}
+
+int InstancedObjectGL::addInstance(const ObjectInstance& instance) {
+    this->instances.push_back(instance);
+    this->states.push_back(InstanceState());
+    updateModel(this->instances.size() - 1);
+    return (int)this->instances.size() - 1;
+}
+
+void InstancedObjectGL::setInstance(int index, const ObjectInstance& instance) {
+    this->instances[index] = instance;
+    updateModel(index);
+}
+
+const ObjectInstance& InstancedObjectGL::getInstance(int index) const {
+    return this->instances[index];
+}
+
+void InstancedObjectGL::removeInstance(int index) {
+    this->instances[index] = this->instances.back();
+    this->states[index] = this->states.back();
+    this->instances.pop_back();
+    this->states.pop_back();
+}
+
+void InstancedObjectGL::clearInstances() {
+    this->instances.clear();
+    this->states.clear();
+}
+
+size_t InstancedObjectGL::instanceCount() const {
+    return this->instances.size();
+}
+
+void InstancedObjectGL::lodRange(int& lowest, int& highest) const {
+    lowest = highest = 0;
+    for (size_t i = 0; i < this->drawList.size(); i++) {
+        int level = this->states[this->drawList[i]].lodLevel;
+        lowest = i == 0 ? level : min(lowest, level);
+        highest = i == 0 ? level : max(highest, level);
+    }
+}
+
+void InstancedObjectGL::updateModel(size_t index) {
+    const ObjectInstance& instance = this->instances[index];
+    glm::mat4 model = glm::translate(glm::mat4(1), instance.position);
+    model = glm::rotate(model, glm::radians(instance.angle), this->upVector);
+    this->states[index].model = glm::scale(model, glm::vec3(instance.scale));
+}
+
+void InstancedObjectGL::worldTriangles(vector<glm::vec3>& corners) const {
+    for (size_t i = 0; i < this->instances.size(); i++) {
+        if (this->instances[i].visible) {
+            appendTriangles(this->states[i].model, corners);
+        }
+    }
+}
+
+void InstancedObjectGL::draw() {
+    this->trianglesDrawn = 0;
+    this->instancesDrawn = 0;
+    this->drawList.clear();
+    if (this->instances.empty()) {
+        return;
+    }
+    glPushMatrix();
+
+    glTranslatef(PosX, PosY, PosZ); // Move all the instances
+    glRotatef(angle, this->upVector.x, this->upVector.y, this->upVector.z);
+    glScalef(scale, scale, scale);
+
+    // Apply the operations of the whole object
+    int objectMaterial = -1;
+    int currentMaterial = NO_MATERIAL;
+    if (!applyShapeOps(0, objectMaterial, currentMaterial)) {
+        glPopMatrix();
+        return; // hidden
+    }
+
+    // Cull the instances and pick their level of detail
+    GLfloat modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glm::mat4 base = glm::make_mat4(modelview);
+    glm::mat4 clip = Frustum::currentClipMatrix();
+    for (size_t i = 0; i < this->instances.size(); i++) {
+        if (!this->instances[i].visible) {
+            continue;
+        }
+        InstanceState& state = this->states[i];
+        glm::mat4 instanceClip = clip * state.model;
+        if (cullingEnabled && !Frustum::fromClipMatrix(instanceClip).contains(this->mesh->bounds)) {
+            cullStats.objectsCulled++;
+            cullStats.shapesCulled += (int)this->mesh->shapes.size();
+            continue;
+        }
+        cullStats.objectsDrawn++;
+        state.lodLevel = lodEnabled ? nextLodLevel(projectedRadius(instanceClip), state.lodLevel) : 0;
+        state.modelview = base * state.model;
+        this->drawList.push_back(i);
+    }
+    this->instancesDrawn = (int)this->drawList.size();
+    if (this->drawList.empty()) {
+        glPopMatrix();
+        return;
+    }
+    bindMesh();
+
+    // Draw every material range for all the instances before moving to the next one
+    for (size_t s = 0; s < this->mesh->shapes.size(); s++) {
+        glm::mat4 shapeMatrix;
+        int shapeMaterial = -1; // material overrides work on the whole object only
+        if (!shapeTransform(s + 1, shapeMatrix, shapeMaterial)) {
+            continue; // hidden
+        }
+        cullStats.shapesDrawn += (int)this->drawList.size();
+
+        for (const DrawRange& range : this->mesh->shapes[s].ranges) {
+            const MeshMaterial& material = objectMaterial >= 0 ? this->materialOverrides[objectMaterial] : range.material;
+            int materialId = objectMaterial >= 0 ? -3 - objectMaterial : range.materialId;
+            if (materialId != currentMaterial) {
+                applyMaterial(material);
+                currentMaterial = materialId;
+            }
+
+            glm::vec4 appliedTint(1);
+            for (size_t i : this->drawList) {
+                const glm::vec4& tint = this->instances[i].tint;
+                if (tint != appliedTint) {
+                    glm::vec4 color = glm::make_vec4(material.diffuse) * tint;
+                    glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, glm::value_ptr(color));
+                    appliedTint = tint;
+                    currentMaterial = NO_MATERIAL; // the next range must set its color again
+                }
+                glLoadMatrixf(glm::value_ptr(this->states[i].modelview * shapeMatrix));
+                const IndexSpan& span = range.lods[this->states[i].lodLevel];
+                glDrawElements(GL_TRIANGLES, span.indexCount, GL_UNSIGNED_INT, indexData(span.firstIndex));
+                this->trianglesDrawn += span.indexCount / 3;
+            }
+        }
+    }
+
+    unbindMesh();
+
+    // Clear texture
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopMatrix();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ObjectGL.h"
+
+// the placement and color of one copy of an instanced object
+struct ObjectInstance {
+    glm::vec3 position = glm::vec3(0);
+    GLfloat angle = 0; // rotation around the object up vector (degrees)
+    GLfloat scale = 1.0f;
+    glm::vec4 tint = glm::vec4(1); // multiplies the ambient and diffuse color of every material
+    bool visible = true;
+};
+
+// Many copies of one .obj model sharing a single mesh, its buffers and textures.
+// The instances are placed relative to the object position, angle and scale, so moving the object moves
+// them all. The mesh is bound once and every material range is drawn for all the visible instances in a
+// row, with the material set once per range (and the tint only when it changes). Each instance is culled
+// and picks its level of detail on its own. Shape operations are applied to every instance; only their
+// transforms and visibility are used, material overrides and callbacks work on the whole object only.
+class InstancedObjectGL : public ObjectGL {
+public:
+    InstancedObjectGL(string inputfile, glm::vec3 upVector = glm::vec3(0, 1, 0));
+
+    int addInstance(const ObjectInstance& instance); // returns the index of the new instance
+    void setInstance(int index, const ObjectInstance& instance); // move, recolor or hide an instance
+    const ObjectInstance& getInstance(int index) const;
+    void removeInstance(int index); // the last instance takes the index of the removed one
+    void clearInstances();
+    size_t instanceCount() const;
+
+    int instancesDrawn = 0; // the instances left after culling in the last draw
+    void lodRange(int& lowest, int& highest) const; // the levels of detail of the instances in the last draw (0 if none)
+    void draw() override; // draw every visible instance
+    void worldTriangles(vector<glm::vec3>& corners) const override; // the triangles of every visible instance
+
+private:
+    // what is computed from an instance when it changes, or once per frame
+    struct InstanceState {
+        glm::mat4 model; // the instance transform, relative to the object
+        glm::mat4 modelview; // the object and instance transforms of the frame
+        int lodLevel = 0;
+    };
+
+    vector<ObjectInstance> instances;
+    vector<InstanceState> states; // parallel to the instances
+    vector<size_t> drawList; // the instances drawn this frame
+    void updateModel(size_t index); // rebuild the model matrix of an instance
+};
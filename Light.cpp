@@ -1,4 +1,5 @@
 #include "Light.h"
+#include "Random.h"
 
 // Constructor for the Light class
 Light::Light(int id, GLfloat PosX, GLfloat PosY, GLfloat PosZ, string object, GLfloat scale,
@@ -105,8 +106,10 @@ void Light::addlight() {
     glLightfv(this->id, GL_SPOT_DIRECTION, direction);
     glLightf(this->id, GL_SPOT_CUTOFF, this->cutoff);
     glLightf(this->id, GL_SPOT_EXPONENT, this->exponent);
+}
 
-    // Update flicker effect if enabled
+// Method to advance the effects by one simulation tick, so the flicker speed does not follow the frame rate
+void Light::tick() {
     if (flicker) {
         updateFlicker();
     }
@@ -135,11 +138,12 @@ void Light::fixDirection() {
 
 // Method to generate random colors for the flicker effect
 void Light::generateFlickerColors() {
+    RandomStream random = Random::stream("light flicker", this->id); // every light flickers its own colors, the same for a seed
     for (int i = 0; i < 10; ++i) {
         flickerColors.push_back(glm::vec3(
-            static_cast<float>(rand()) / RAND_MAX,
-            static_cast<float>(rand()) / RAND_MAX,
-            static_cast<float>(rand()) / RAND_MAX
+            random.uniform(),
+            random.uniform(),
+            random.uniform()
         ));
     }
 }
@@ -31,6 +31,7 @@ public:
     void enableFlicker(); // Enable flicker effect
     void disableFlicker(); // Disable flicker effect
     void updateFlicker(); // update the light color for the flicker effect
+    void tick(); // advance the effects by one simulation tick
     ~Light() = default;
 
 private:
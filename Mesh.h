@@ -0,0 +1,112 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+class MappedFile;
+
+const int MESH_LOD_LEVELS = 4; // level 0 is the imported mesh, every next level keeps about half the triangles
+
+// interleaved vertex layout stored in the vertex buffer
+struct MeshVertex {
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLfloat texcoord[2];
+};
+
+// the opengl state of a material, resolved once when the object is loaded
+struct MeshMaterial {
+    GLfloat diffuse[4]; // ambient and diffuse color
+    GLfloat specular[4]; // specular color
+    GLfloat emission[4]; // emission color
+    GLfloat shininess; // specular exponent
+    GLuint texture; // opengl texture id (0 for no texture)
+};
+
+// a contiguous part of the index buffer
+struct IndexSpan {
+    GLuint firstIndex; // offset (in indices) of the first index of the span
+    GLsizei indexCount; // number of indices in the span
+};
+
+// all the triangles of a shape that use the same material, contiguous in the index buffer
+struct DrawRange {
+    IndexSpan lods[MESH_LOD_LEVELS]; // the triangles of each level of detail, lods[0] is the full detail
+    int materialId; // index to the object materials, -1 for the default material
+    MeshMaterial material; // the material state to set before drawing the range
+};
+
+// an axis aligned box and a sphere around some vertices (object space)
+struct MeshBounds {
+    GLfloat lower[3]; // the box corners
+    GLfloat upper[3];
+    GLfloat center[3]; // the sphere around the center of the box
+    GLfloat radius;
+};
+
+// the triangulated part of the index buffer that belongs to one .obj shape
+struct MeshShape {
+    std::string name; // the shape name (used by the shape tasks)
+    std::vector<DrawRange> ranges; // the shape triangles grouped by material
+    MeshBounds bounds; // the bounds of the shape vertices
+};
+
+// a material of the .obj file, before its texture is created
+struct MeshMaterialInfo {
+    MeshMaterial material; // the material colors (texture id is not set yet)
+    std::string textureName; // the diffuse texture file name as written in the .mtl file
+};
+
+// how much the import optimizations improved the vertex reuse
+struct MeshOptimizeStats {
+    size_t importedVertices; // vertices written by the importer (one per polygon corner)
+    float acmrBefore; // average cache miss per triangle as imported
+    float acmrAfter; // average cache miss per triangle after welding and reordering
+};
+
+// the triangulated geometry of an .obj file, either built by the importer or read from the mesh cache
+class MeshData {
+public:
+    std::vector<MeshShape> shapes; // the draw ranges of each shape
+    std::vector<MeshMaterialInfo> materials; // the materials used by the draw ranges
+    const MeshVertex* vertices = NULL; // all the shapes vertices
+    size_t vertexCount = 0;
+    const GLuint* indices = NULL; // the triangles indices to vertices
+    size_t indexCount = 0;
+    MeshBounds bounds = {}; // the bounds of all the vertices
+    MeshOptimizeStats optimizeStats = {}; // the result of the import optimizations
+
+    MeshData() = default;
+    MeshData(const MeshData&) = delete; // vertices and indices may point into the owned storage
+    MeshData& operator=(const MeshData&) = delete;
+
+    // take ownership of vertices and indices built in memory
+    void setGeometry(std::vector<MeshVertex>&& vertices, std::vector<GLuint>&& indices) {
+        this->ownedVertices = std::move(vertices);
+        this->ownedIndices = std::move(indices);
+        this->mapping.reset();
+        this->vertices = this->ownedVertices.data();
+        this->vertexCount = this->ownedVertices.size();
+        this->indices = this->ownedIndices.data();
+        this->indexCount = this->ownedIndices.size();
+    }
+
+    // use vertices and indices that live inside a memory mapped file (kept open while in use)
+    void setGeometry(std::shared_ptr<MappedFile> mapping, const MeshVertex* vertices, size_t vertexCount,
+        const GLuint* indices, size_t indexCount) {
+        this->ownedVertices.clear();
+        this->ownedIndices.clear();
+        this->mapping = mapping;
+        this->vertices = vertices;
+        this->vertexCount = vertexCount;
+        this->indices = indices;
+        this->indexCount = indexCount;
+    }
+
+private:
+    std::vector<MeshVertex> ownedVertices; // storage when the geometry was built in memory
+    std::vector<GLuint> ownedIndices;
+    std::shared_ptr<MappedFile> mapping; // storage when the geometry was read from the cache
+};
@@ -0,0 +1,430 @@
+#include "MeshCache.h"
+#include "MeshOptimize.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// cache file layout: header, then each section aligned to CACHE_ALIGNMENT
+//   strings   - the .obj path followed by the shape names and texture names
+//   materials - CachedMaterial records
+//   shapes    - CachedShape records
+//   ranges    - CachedRange records
+//   vertices  - MeshVertex records (uploaded to opengl as is)
+//   indices   - GLuint triangle indices (uploaded to opengl as is)
+
+static const char CACHE_MAGIC[4] = { 'R', 'G', 'L', 'M' };
+static const uint64_t CACHE_ALIGNMENT = 16;
+
+struct CacheSection {
+    uint64_t offset; // byte offset from the start of the file
+    uint64_t count; // number of records (bytes for the strings section)
+};
+
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize; // size of the .obj file the cache was built from
+    int64_t sourceModified; // modification time of the .obj file the cache was built from
+    double importMilliseconds; // how long the import took when the cache was written
+    uint32_t pathLength; // the .obj path is stored at the start of the strings section
+    uint32_t vertexSize; // sizeof(MeshVertex), guards against layout changes
+    MeshBounds bounds; // the bounds of the whole mesh
+    uint64_t importedVertices; // the import optimization statistics
+    float acmrBefore;
+    float acmrAfter;
+    CacheSection strings;
+    CacheSection materials;
+    CacheSection shapes;
+    CacheSection ranges;
+    CacheSection vertices;
+    CacheSection indices;
+    uint64_t fileSize; // total size, guards against truncated files
+};
+
+struct CachedMaterial {
+    GLfloat diffuse[4];
+    GLfloat specular[4];
+    GLfloat emission[4];
+    GLfloat shininess;
+    uint32_t textureNameOffset; // offset in the strings section
+    uint32_t textureNameLength;
+};
+
+struct CachedShape {
+    uint32_t nameOffset; // offset in the strings section
+    uint32_t nameLength;
+    uint32_t firstRange; // index of the first range of the shape in the ranges section
+    uint32_t rangeCount;
+    MeshBounds bounds;
+};
+
+struct CachedRange {
+    uint32_t firstIndex[MESH_LOD_LEVELS]; // the index span of every level of detail
+    uint32_t indexCount[MESH_LOD_LEVELS];
+    int32_t materialId;
+};
+
+// the load time of each mesh since startup
+struct MeshLoadTiming {
+    string file;
+    bool fromCache;
+    double milliseconds;
+    double importMilliseconds;
+    MeshOptimizeStats optimizeStats;
+    size_t vertexCount;
+};
+static vector<MeshLoadTiming> meshLoadTimings;
+static mutex meshLoadTimingsMutex; // meshes are loaded on the asset loader workers
+
+static string cacheFileName(const string& objFile) {
+    return objFile + MESH_CACHE_EXTENSION;
+}
+
+// get the size and modification time of a file
+static bool getFileStamp(const string& path, uint64_t& size, int64_t& modified) {
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(path.c_str(), &info) != 0) {
+        return false;
+    }
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+#endif
+    size = (uint64_t)info.st_size;
+    modified = (int64_t)info.st_mtime;
+    return true;
+}
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+}
+
+static bool sectionFits(const CacheSection& section, size_t recordSize, uint64_t fileSize) {
+    return section.offset % sizeof(uint32_t) == 0 && section.offset <= fileSize &&
+        section.count <= (fileSize - section.offset) / recordSize;
+}
+
+shared_ptr<MappedFile> MappedFile::open(const string& path) {
+    shared_ptr<MappedFile> mapped(new MappedFile());
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    mapped->file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    mapped->mapping = mapping;
+    mapped->bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (mapped->bytes == NULL) {
+        return NULL;
+    }
+    mapped->length = (size_t)size.QuadPart;
+#else
+    mapped->file = ::open(path.c_str(), O_RDONLY);
+    if (mapped->file < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(mapped->file, &info) != 0 || info.st_size == 0) {
+        return NULL;
+    }
+    void* bytes = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, mapped->file, 0);
+    if (bytes == MAP_FAILED) {
+        return NULL;
+    }
+    mapped->bytes = (const unsigned char*)bytes;
+    mapped->length = (size_t)info.st_size;
+#endif
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (this->bytes != NULL) {
+        UnmapViewOfFile(this->bytes);
+    }
+    if (this->mapping != NULL) {
+        CloseHandle(this->mapping);
+    }
+    if (this->file != NULL) {
+        CloseHandle(this->file);
+    }
+#else
+    if (this->bytes != NULL) {
+        munmap((void*)this->bytes, this->length);
+    }
+    if (this->file >= 0) {
+        close(this->file);
+    }
+#endif
+}
+
+bool loadMeshCache(const string& objFile, MeshData& mesh, double& importMilliseconds) {
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    if (!getFileStamp(objFile, sourceSize, sourceModified)) {
+        return false;
+    }
+
+    shared_ptr<MappedFile> file = MappedFile::open(cacheFileName(objFile));
+    if (!file || file->size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+
+    // check the cache matches this build and the current .obj file
+    const unsigned char* data = file->data();
+    MeshCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != MESH_CACHE_VERSION ||
+        header.vertexSize != sizeof(MeshVertex) || header.fileSize != file->size()) {
+        std::cout << "Mesh cache of " << objFile << " is from another version, rebuilding" << std::endl;
+        return false;
+    }
+    if (header.sourceSize != sourceSize || header.sourceModified != sourceModified) {
+        std::cout << "Mesh cache of " << objFile << " is out of date, rebuilding" << std::endl;
+        return false;
+    }
+    if (!sectionFits(header.strings, 1, header.fileSize) ||
+        !sectionFits(header.materials, sizeof(CachedMaterial), header.fileSize) ||
+        !sectionFits(header.shapes, sizeof(CachedShape), header.fileSize) ||
+        !sectionFits(header.ranges, sizeof(CachedRange), header.fileSize) ||
+        !sectionFits(header.vertices, sizeof(MeshVertex), header.fileSize) ||
+        !sectionFits(header.indices, sizeof(GLuint), header.fileSize) ||
+        header.pathLength > header.strings.count) {
+        std::cerr << "Mesh cache of " << objFile << " is corrupted, rebuilding" << std::endl;
+        return false;
+    }
+
+    const char* strings = (const char*)(data + header.strings.offset);
+    if (string(strings, header.pathLength) != objFile) {
+        return false; // the cache belongs to another path (the .obj was copied or moved)
+    }
+
+    const CachedMaterial* materials = (const CachedMaterial*)(data + header.materials.offset);
+    const CachedShape* shapes = (const CachedShape*)(data + header.shapes.offset);
+    const CachedRange* ranges = (const CachedRange*)(data + header.ranges.offset);
+    const MeshVertex* vertices = (const MeshVertex*)(data + header.vertices.offset);
+    const GLuint* indices = (const GLuint*)(data + header.indices.offset);
+
+    mesh.materials.resize((size_t)header.materials.count);
+    for (size_t m = 0; m < mesh.materials.size(); m++) {
+        const CachedMaterial& cached = materials[m];
+        MeshMaterialInfo& material = mesh.materials[m];
+        memcpy(material.material.diffuse, cached.diffuse, sizeof(cached.diffuse));
+        memcpy(material.material.specular, cached.specular, sizeof(cached.specular));
+        memcpy(material.material.emission, cached.emission, sizeof(cached.emission));
+        material.material.shininess = cached.shininess;
+        material.material.texture = 0;
+        if ((uint64_t)cached.textureNameOffset + cached.textureNameLength > header.strings.count) {
+            return false;
+        }
+        material.textureName.assign(strings + cached.textureNameOffset, cached.textureNameLength);
+    }
+
+    mesh.shapes.resize((size_t)header.shapes.count);
+    for (size_t s = 0; s < mesh.shapes.size(); s++) {
+        const CachedShape& cached = shapes[s];
+        if ((uint64_t)cached.nameOffset + cached.nameLength > header.strings.count ||
+            (uint64_t)cached.firstRange + cached.rangeCount > header.ranges.count) {
+            return false;
+        }
+        mesh.shapes[s].name.assign(strings + cached.nameOffset, cached.nameLength);
+        mesh.shapes[s].bounds = cached.bounds;
+        mesh.shapes[s].ranges.clear();
+        for (uint32_t r = 0; r < cached.rangeCount; r++) {
+            const CachedRange& cachedRange = ranges[cached.firstRange + r];
+            if (cachedRange.materialId >= (int32_t)header.materials.count) {
+                return false;
+            }
+            DrawRange range = {};
+            for (int level = 0; level < MESH_LOD_LEVELS; level++) {
+                if ((uint64_t)cachedRange.firstIndex[level] + cachedRange.indexCount[level] > header.indices.count) {
+                    return false;
+                }
+                range.lods[level].firstIndex = cachedRange.firstIndex[level];
+                range.lods[level].indexCount = (GLsizei)cachedRange.indexCount[level];
+            }
+            range.materialId = cachedRange.materialId;
+            mesh.shapes[s].ranges.push_back(range);
+        }
+    }
+
+    // the vertices and indices stay in the mapping and are uploaded straight from it
+    mesh.setGeometry(file, vertices, (size_t)header.vertices.count, indices, (size_t)header.indices.count);
+    mesh.bounds = header.bounds;
+    mesh.optimizeStats.importedVertices = (size_t)header.importedVertices;
+    mesh.optimizeStats.acmrBefore = header.acmrBefore;
+    mesh.optimizeStats.acmrAfter = header.acmrAfter;
+    importMilliseconds = header.importMilliseconds;
+    return true;
+}
+
+bool saveMeshCache(const string& objFile, const MeshData& mesh, double importMilliseconds) {
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexSize = sizeof(MeshVertex);
+    header.importMilliseconds = importMilliseconds;
+    header.bounds = mesh.bounds;
+    header.importedVertices = mesh.optimizeStats.importedVertices;
+    header.acmrBefore = mesh.optimizeStats.acmrBefore;
+    header.acmrAfter = mesh.optimizeStats.acmrAfter;
+    if (!getFileStamp(objFile, header.sourceSize, header.sourceModified)) {
+        return false;
+    }
+
+    // gather the strings and the fixed size records
+    string strings = objFile;
+    header.pathLength = (uint32_t)objFile.size();
+
+    vector<CachedMaterial> materials;
+    for (const MeshMaterialInfo& material : mesh.materials) {
+        CachedMaterial cached;
+        memcpy(cached.diffuse, material.material.diffuse, sizeof(cached.diffuse));
+        memcpy(cached.specular, material.material.specular, sizeof(cached.specular));
+        memcpy(cached.emission, material.material.emission, sizeof(cached.emission));
+        cached.shininess = material.material.shininess;
+        cached.textureNameOffset = (uint32_t)strings.size();
+        cached.textureNameLength = (uint32_t)material.textureName.size();
+        strings += material.textureName;
+        materials.push_back(cached);
+    }
+
+    vector<CachedShape> shapes;
+    vector<CachedRange> ranges;
+    for (const MeshShape& shape : mesh.shapes) {
+        CachedShape cached;
+        cached.nameOffset = (uint32_t)strings.size();
+        cached.nameLength = (uint32_t)shape.name.size();
+        cached.firstRange = (uint32_t)ranges.size();
+        cached.rangeCount = (uint32_t)shape.ranges.size();
+        cached.bounds = shape.bounds;
+        strings += shape.name;
+        shapes.push_back(cached);
+        for (const DrawRange& range : shape.ranges) {
+            CachedRange cachedRange;
+            for (int level = 0; level < MESH_LOD_LEVELS; level++) {
+                cachedRange.firstIndex[level] = range.lods[level].firstIndex;
+                cachedRange.indexCount[level] = (uint32_t)range.lods[level].indexCount;
+            }
+            cachedRange.materialId = range.materialId;
+            ranges.push_back(cachedRange);
+        }
+    }
+
+    // lay out the sections
+    uint64_t offset = alignOffset(sizeof(MeshCacheHeader));
+    CacheSection* sections[] = { &header.strings, &header.materials, &header.shapes, &header.ranges, &header.vertices, &header.indices };
+    uint64_t counts[] = { strings.size(), materials.size(), shapes.size(), ranges.size(), mesh.vertexCount, mesh.indexCount };
+    uint64_t sizes[] = { 1, sizeof(CachedMaterial), sizeof(CachedShape), sizeof(CachedRange), sizeof(MeshVertex), sizeof(GLuint) };
+    for (int i = 0; i < 6; i++) {
+        sections[i]->offset = offset;
+        sections[i]->count = counts[i];
+        offset = alignOffset(offset + counts[i] * sizes[i]);
+    }
+    header.fileSize = offset;
+
+    // write to a temporary file first so a failed write never leaves a broken cache behind
+    string cacheFile = cacheFileName(objFile);
+    string tempFile = cacheFile + ".tmp";
+    {
+        ofstream out(tempFile.c_str(), ios::binary | ios::trunc);
+        if (!out) {
+            std::cerr << "Unable to write mesh cache: " << cacheFile << std::endl;
+            return false;
+        }
+        const void* blocks[] = { strings.data(), materials.data(), shapes.data(), ranges.data(), mesh.vertices, mesh.indices };
+        const char padding[CACHE_ALIGNMENT] = {};
+        out.write((const char*)&header, sizeof(header));
+        uint64_t written = sizeof(header);
+        for (int i = 0; i < 6; i++) {
+            out.write(padding, (streamsize)(sections[i]->offset - written));
+            out.write((const char*)blocks[i], (streamsize)(counts[i] * sizes[i]));
+            written = sections[i]->offset + counts[i] * sizes[i];
+        }
+        out.write(padding, (streamsize)(header.fileSize - written));
+        if (!out) {
+            std::cerr << "Unable to write mesh cache: " << cacheFile << std::endl;
+            out.close();
+            remove(tempFile.c_str());
+            return false;
+        }
+    }
+    remove(cacheFile.c_str());
+    if (rename(tempFile.c_str(), cacheFile.c_str()) != 0) {
+        remove(tempFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+void recordMeshLoad(const string& objFile, const MeshData& mesh, bool fromCache, double milliseconds, double importMilliseconds) {
+    MeshLoadTiming timing = { objFile, fromCache, milliseconds, importMilliseconds, mesh.optimizeStats, mesh.vertexCount };
+    lock_guard<mutex> lock(meshLoadTimingsMutex);
+    meshLoadTimings.push_back(timing);
+}
+
+void printMeshLoadReport() {
+    double cachedTotal = 0, importedTotal = 0, replacedTotal = 0;
+    int cachedCount = 0;
+    lock_guard<mutex> lock(meshLoadTimingsMutex);
+
+    std::cout << "Mesh load times:" << std::endl;
+    for (const MeshLoadTiming& timing : meshLoadTimings) {
+        std::cout << "  " << std::left << std::setw(32) << timing.file << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << timing.milliseconds << " ms";
+        if (timing.fromCache) {
+            std::cout << "  (cache, import took " << timing.importMilliseconds << " ms)";
+            cachedTotal += timing.milliseconds;
+            replacedTotal += timing.importMilliseconds;
+            cachedCount++;
+        }
+        else {
+            std::cout << "  (imported .obj, cache written)";
+            importedTotal += timing.milliseconds;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "  imported: " << importedTotal << " ms, cached: " << cachedTotal << " ms";
+    if (cachedCount > 0) {
+        std::cout << " (the same " << cachedCount << " meshes took " << replacedTotal << " ms to import)";
+    }
+    std::cout << std::endl;
+
+    std::cout << "Vertex reuse (ACMR with a " << VERTEX_CACHE_SIZE << " vertex fifo cache):" << std::endl;
+    for (const MeshLoadTiming& timing : meshLoadTimings) {
+        std::cout << "  " << std::left << std::setw(32) << timing.file << std::right
+            << std::setw(8) << timing.optimizeStats.importedVertices << " -> " << std::setw(8) << timing.vertexCount << " vertices"
+            << ", ACMR " << timing.optimizeStats.acmrBefore << " -> " << timing.optimizeStats.acmrAfter << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include "Mesh.h"
+
+using namespace std;
+
+// Binary cache of imported meshes, stored next to each .obj file.
+// The cache holds the optimized vertices, indices (with the levels of detail), draw ranges, materials
+// and bounds, and is keyed by the .obj path, size and modification time. A valid cache is memory mapped
+// and its vertices and indices are used in place, so tinyobj does not run at all on later launches.
+
+const unsigned int MESH_CACHE_VERSION = 4; // bump whenever the cache layout or the importer output changes
+const string MESH_CACHE_EXTENSION = ".meshcache"; // appended to the .obj file name
+
+// a read only memory mapping of a whole file
+class MappedFile {
+public:
+    static shared_ptr<MappedFile> open(const string& path); // map a file, returns null on failure
+    ~MappedFile();
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* bytes = NULL; // start of the mapped view
+    size_t length = 0; // size of the mapped view in bytes
+#ifdef _WIN32
+    void* file = NULL; // file handle
+    void* mapping = NULL; // file mapping handle
+#else
+    int file = -1; // file descriptor
+#endif
+};
+
+// load the cached mesh of an .obj file, returns false if there is no cache or it is out of date
+// importMilliseconds is set to the time the original import took when the cache was written
+bool loadMeshCache(const string& objFile, MeshData& mesh, double& importMilliseconds);
+
+// write the cache of an imported .obj file, returns false if the cache could not be written
+bool saveMeshCache(const string& objFile, const MeshData& mesh, double importMilliseconds);
+
+// record how long loading an .obj file took and its vertex reuse for the startup report
+void recordMeshLoad(const string& objFile, const MeshData& mesh, bool fromCache, double milliseconds, double importMilliseconds);
+
+// print the load time of every mesh, comparing cached loads against the import they replaced,
+// and the vertex cache efficiency of every mesh before and after the import optimizations
+void printMeshLoadReport();
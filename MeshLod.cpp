@@ -0,0 +1,262 @@
+#include "MeshLod.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+// the sum of squared distances to a set of planes, as the symmetric matrix of the plane equations
+struct Quadric {
+    double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+
+    void addPlane(double x, double y, double z, double w) {
+        a00 += x * x; a01 += x * y; a02 += x * z; a03 += x * w;
+        a11 += y * y; a12 += y * z; a13 += y * w;
+        a22 += z * z; a23 += z * w;
+        a33 += w * w;
+    }
+
+    void add(const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+    }
+
+    double error(const GLfloat* p) const {
+        double x = p[0], y = p[1], z = p[2];
+        return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+            + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+            + a22 * z * z + 2 * a23 * z
+            + a33;
+    }
+};
+
+// a candidate collapse of the position "from" onto the position "to"
+struct Collapse {
+    int from;
+    int to;
+    double cost;
+    bool operator<(const Collapse& other) const { return cost < other.cost; }
+};
+
+static void triangleNormal(const GLfloat* p0, const GLfloat* p1, const GLfloat* p2, double* normal) {
+    double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+vector<GLuint> simplifyTriangles(const vector<MeshVertex>& vertices, const GLuint* indices, size_t indexCount,
+    size_t targetIndexCount, float maxError) {
+    // welded vertices still split where the normals or texture coordinates do, so the topology is built on the positions
+    map<tuple<GLfloat, GLfloat, GLfloat>, int> positionIds;
+    vector<GLuint> positionVertex; // a vertex of every position
+    vector<char> locked; // positions that may not move (range border and texture seams)
+    vector<int> triangles(indexCount); // the position of every corner
+    for (size_t i = 0; i < indexCount; i++) {
+        const MeshVertex& vertex = vertices[indices[i]];
+        tuple<GLfloat, GLfloat, GLfloat> key(vertex.position[0], vertex.position[1], vertex.position[2]);
+        map<tuple<GLfloat, GLfloat, GLfloat>, int>::iterator it = positionIds.find(key);
+        if (it == positionIds.end()) {
+            it = positionIds.insert(make_pair(key, (int)positionVertex.size())).first;
+            positionVertex.push_back(indices[i]);
+            locked.push_back(0);
+        }
+        else {
+            const MeshVertex& other = vertices[positionVertex[it->second]];
+            if (other.texcoord[0] != vertex.texcoord[0] || other.texcoord[1] != vertex.texcoord[1]) {
+                locked[it->second] = 1; // texture seam
+            }
+        }
+        triangles[i] = it->second;
+    }
+    vector<GLuint> corners(indices, indices + indexCount); // the vertex of every corner
+    size_t positionCount = positionVertex.size();
+    size_t triangleCount = indexCount / 3;
+
+    // lock the border edges (used by one triangle) and the non manifold ones
+    map<pair<int, int>, int> edgeUses;
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int e = 0; e < 3; e++) {
+            int a = triangles[t * 3 + e], b = triangles[t * 3 + (e + 1) % 3];
+            edgeUses[make_pair(min(a, b), max(a, b))]++;
+        }
+    }
+    for (const pair<const pair<int, int>, int>& edge : edgeUses) {
+        if (edge.second != 2) {
+            locked[edge.first.first] = 1;
+            locked[edge.first.second] = 1;
+        }
+    }
+
+    // the quadric of every position is built from the planes of its triangles
+    vector<Quadric> quadrics(positionCount, Quadric());
+    GLfloat lower[3] = { INFINITY, INFINITY, INFINITY };
+    GLfloat upper[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (size_t t = 0; t < triangleCount; t++) {
+        const GLfloat* p0 = vertices[corners[t * 3]].position;
+        double normal[3];
+        triangleNormal(p0, vertices[corners[t * 3 + 1]].position, vertices[corners[t * 3 + 2]].position, normal);
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0) {
+            double x = normal[0] / length, y = normal[1] / length, z = normal[2] / length;
+            Quadric plane = Quadric();
+            plane.addPlane(x, y, z, -(x * p0[0] + y * p0[1] + z * p0[2]));
+            for (int c = 0; c < 3; c++) {
+                quadrics[triangles[t * 3 + c]].add(plane);
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            for (int i = 0; i < 3; i++) {
+                lower[i] = min(lower[i], vertices[corners[t * 3 + c]].position[i]);
+                upper[i] = max(upper[i], vertices[corners[t * 3 + c]].position[i]);
+            }
+        }
+    }
+    double extent = max(upper[0] - lower[0], max(upper[1] - lower[1], upper[2] - lower[2]));
+    double errorLimit = (maxError * extent) * (maxError * extent);
+
+    vector<char> alive(triangleCount, 1);
+    size_t aliveCount = triangleCount;
+    while (aliveCount * 3 > targetIndexCount) {
+        // the triangles around every position
+        vector<vector<int>> around(positionCount);
+        for (size_t t = 0; t < triangleCount; t++) {
+            if (alive[t]) {
+                for (int c = 0; c < 3; c++) {
+                    around[triangles[t * 3 + c]].push_back((int)t);
+                }
+            }
+        }
+
+        // every edge can collapse in both directions, cheapest first
+        vector<Collapse> collapses;
+        for (size_t t = 0; t < triangleCount; t++) {
+            if (!alive[t]) {
+                continue;
+            }
+            for (int e = 0; e < 3; e++) {
+                int a = triangles[t * 3 + e], b = triangles[t * 3 + (e + 1) % 3];
+                const int ends[2][2] = { { a, b }, { b, a } };
+                for (int d = 0; d < 2; d++) {
+                    int from = ends[d][0], to = ends[d][1];
+                    if (locked[from]) {
+                        continue;
+                    }
+                    Quadric merged = quadrics[from];
+                    merged.add(quadrics[to]);
+                    double cost = merged.error(vertices[positionVertex[to]].position);
+                    if (cost <= errorLimit) {
+                        Collapse collapse = { from, to, cost };
+                        collapses.push_back(collapse);
+                    }
+                }
+            }
+        }
+        sort(collapses.begin(), collapses.end());
+
+        // apply the collapses that do not touch each other in this pass
+        vector<char> touched(positionCount, 0);
+        size_t collapsed = 0;
+        for (const Collapse& collapse : collapses) {
+            if (aliveCount * 3 <= targetIndexCount) {
+                break;
+            }
+            int from = collapse.from, to = collapse.to;
+            if (touched[from] || touched[to]) {
+                continue;
+            }
+
+            // reject collapses that flip a triangle, and find the vertex of "to" on the collapsed edge
+            bool flips = false;
+            GLuint toVertex = positionVertex[to];
+            for (int t : around[from]) {
+                int c = 0;
+                while (triangles[t * 3 + c] != from) {
+                    c++;
+                }
+                const GLuint* corner = &corners[t * 3];
+                bool onEdge = false;
+                for (int k = 0; k < 3; k++) {
+                    if (triangles[t * 3 + k] == to) {
+                        onEdge = true;
+                        toVertex = corner[k];
+                    }
+                }
+                if (onEdge) {
+                    continue; // removed by the collapse
+                }
+                const GLfloat* moved = vertices[positionVertex[to]].position;
+                const GLfloat* p[3] = { vertices[corner[0]].position, vertices[corner[1]].position, vertices[corner[2]].position };
+                double before[3], after[3];
+                triangleNormal(p[0], p[1], p[2], before);
+                p[c] = moved;
+                triangleNormal(p[0], p[1], p[2], after);
+                if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0) {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips) {
+                continue;
+            }
+
+            // move the corners of "from" onto "to", dropping the triangles that became degenerate
+            for (int t : around[from]) {
+                bool degenerate = false;
+                for (int k = 0; k < 3; k++) {
+                    touched[triangles[t * 3 + k]] = 1;
+                    if (triangles[t * 3 + k] == to) {
+                        degenerate = true;
+                    }
+                }
+                if (degenerate) {
+                    alive[t] = 0;
+                    aliveCount--;
+                    continue;
+                }
+                for (int k = 0; k < 3; k++) {
+                    if (triangles[t * 3 + k] == from) {
+                        triangles[t * 3 + k] = to;
+                        corners[t * 3 + k] = toVertex;
+                    }
+                }
+            }
+            quadrics[to].add(quadrics[from]);
+            collapsed++;
+        }
+        if (collapsed == 0) {
+            break; // nothing left under the error limit
+        }
+    }
+
+    vector<GLuint> result;
+    result.reserve(aliveCount * 3);
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (alive[t]) {
+            result.insert(result.end(), corners.begin() + t * 3, corners.begin() + t * 3 + 3);
+        }
+    }
+    return result;
+}
+
+void buildMeshLods(const vector<MeshVertex>& vertices, vector<GLuint>& indices, vector<MeshShape>& shapes) {
+    for (MeshShape& shape : shapes) {
+        for (DrawRange& range : shape.ranges) {
+            for (int level = 1; level < MESH_LOD_LEVELS; level++) {
+                const IndexSpan& previous = range.lods[level - 1];
+                size_t target = (size_t)(previous.indexCount * LOD_LEVEL_RATIO) / 3 * 3;
+                vector<GLuint> simplified = simplifyTriangles(vertices, indices.data() + previous.firstIndex,
+                    previous.indexCount, target, LOD_MAX_ERROR * level);
+                if (simplified.size() == (size_t)previous.indexCount) {
+                    range.lods[level] = previous; // could not simplify further, reuse the previous level
+                    continue;
+                }
+                range.lods[level].firstIndex = (GLuint)indices.size();
+                range.lods[level].indexCount = (GLsizei)simplified.size();
+                indices.insert(indices.end(), simplified.begin(), simplified.end());
+            }
+        }
+    }
+}
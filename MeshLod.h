@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include "Mesh.h"
+
+using namespace std;
+
+// Levels of detail built at import time.
+// Every draw range is simplified on its own by quadric error half edge collapses, so the ranges keep
+// their material. Vertices on the border of a range or on a texture seam are locked, which keeps the
+// material boundaries and the texture mapping in place. Each level is simplified from the previous one.
+
+const float LOD_LEVEL_RATIO = 0.5f; // the triangle count of a level relative to the previous level
+const float LOD_MAX_ERROR = 0.02f; // the largest collapse error, relative to the size of the range
+
+// append the simplified levels of every draw range of the shapes to the indices and fill their lods
+void buildMeshLods(const vector<MeshVertex>& vertices, vector<GLuint>& indices, vector<MeshShape>& shapes);
+
+// simplify a triangle list to about targetIndexCount indices, returns the remaining triangles
+vector<GLuint> simplifyTriangles(const vector<MeshVertex>& vertices, const GLuint* indices, size_t indexCount,
+    size_t targetIndexCount, float maxError);
@@ -0,0 +1,341 @@
+#include "MeshOptimize.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+
+// Forsyth's "linear speed vertex cache optimisation" scoring
+static const int FORSYTH_CACHE_SIZE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+// hash and compare vertices by their bytes, so only exactly equal vertices are welded
+struct VertexHash {
+    size_t operator()(const MeshVertex& vertex) const {
+        const unsigned char* bytes = (const unsigned char*)&vertex;
+        size_t hash = 2166136261u;
+        for (size_t i = 0; i < sizeof(MeshVertex); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+struct VertexEqual {
+    bool operator()(const MeshVertex& a, const MeshVertex& b) const {
+        return memcmp(&a, &b, sizeof(MeshVertex)) == 0;
+    }
+};
+
+size_t weldVertices(vector<MeshVertex>& vertices, vector<GLuint>& indices) {
+    unordered_map<MeshVertex, GLuint, VertexHash, VertexEqual> unique;
+    vector<GLuint> remap(vertices.size());
+    vector<MeshVertex> welded;
+    for (size_t v = 0; v < vertices.size(); v++) {
+        pair<unordered_map<MeshVertex, GLuint, VertexHash, VertexEqual>::iterator, bool> inserted =
+            unique.insert(make_pair(vertices[v], (GLuint)welded.size()));
+        if (inserted.second) {
+            welded.push_back(vertices[v]);
+        }
+        remap[v] = inserted.first->second;
+    }
+    for (GLuint& index : indices) {
+        index = remap[index];
+    }
+    vertices.swap(welded);
+    return vertices.size();
+}
+
+static float forsythScore(int cachePosition, int remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f; // the vertex is not used anymore
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = FORSYTH_LAST_TRIANGLE_SCORE; // used by the last triangle, the order inside it does not matter
+        }
+        else {
+            float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+    // favour the vertices with few triangles left, to finish them and avoid isolated triangles
+    return score + FORSYTH_VALENCE_BOOST_SCALE * pow((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+void optimizeVertexCache(GLuint* indices, size_t indexCount, size_t vertexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // number the vertices of the span from 0
+    vector<int> localId(vertexCount, -1);
+    vector<int> corners(triangleCount * 3);
+    int localCount = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        if (localId[indices[i]] < 0) {
+            localId[indices[i]] = localCount++;
+        }
+        corners[i] = localId[indices[i]];
+    }
+
+    // the triangles of every vertex (the first "remaining" entries are the ones not emitted yet)
+    vector<int> remaining(localCount, 0);
+    for (int corner : corners) {
+        remaining[corner]++;
+    }
+    vector<int> firstTriangle(localCount + 1, 0);
+    for (int v = 0; v < localCount; v++) {
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    }
+    vector<int> vertexTriangles(triangleCount * 3);
+    vector<int> filled(localCount, 0);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int c = 0; c < 3; c++) {
+            int v = corners[t * 3 + c];
+            vertexTriangles[firstTriangle[v] + filled[v]++] = (int)t;
+        }
+    }
+
+    vector<int> cachePosition(localCount, -1);
+    vector<float> vertexScore(localCount);
+    for (int v = 0; v < localCount; v++) {
+        vertexScore[v] = forsythScore(-1, remaining[v]);
+    }
+    vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[corners[t * 3]] + vertexScore[corners[t * 3 + 1]] + vertexScore[corners[t * 3 + 2]];
+    }
+    vector<char> emitted(triangleCount, 0);
+
+    vector<GLuint> output;
+    output.reserve(triangleCount * 3);
+    vector<int> cache, newCache;
+    size_t firstRemaining = 0; // no triangle before it is left, so the restarts scan every triangle once in all
+    int best = (int)(max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    while (output.size() < triangleCount * 3) {
+        if (best < 0) {
+            // nothing in the cache has triangles left (a new island), start again from the next triangle left
+            while (emitted[firstRemaining]) {
+                firstRemaining++;
+            }
+            best = (int)firstRemaining;
+        }
+
+        // emit the triangle and remove it from its vertices
+        emitted[best] = 1;
+        newCache.clear();
+        for (int c = 0; c < 3; c++) {
+            int v = corners[best * 3 + c];
+            output.push_back(indices[best * 3 + c]);
+            int* begin = &vertexTriangles[firstTriangle[v]];
+            int* end = begin + remaining[v];
+            *find(begin, end, best) = *(end - 1);
+            remaining[v]--;
+            newCache.push_back(v);
+        }
+
+        // its vertices move to the front of the cache
+        for (int v : cache) {
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2]) {
+                newCache.push_back(v);
+            }
+        }
+        for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); i++) {
+            cachePosition[newCache[i]] = -1; // pushed out of the cache
+        }
+
+        // update the scores of the vertices that moved and of their triangles, and find the next triangle
+        best = -1;
+        float bestScore = -1e30f;
+        for (size_t i = 0; i < newCache.size(); i++) {
+            int v = newCache[i];
+            if (i < (size_t)FORSYTH_CACHE_SIZE) {
+                cachePosition[v] = (int)i;
+            }
+            float score = forsythScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (int k = 0; k < remaining[v]; k++) {
+                int t = vertexTriangles[firstTriangle[v] + k];
+                triangleScore[t] += delta;
+            }
+        }
+        for (size_t i = 0; i < newCache.size() && i < (size_t)FORSYTH_CACHE_SIZE; i++) {
+            int v = newCache[i];
+            for (int k = 0; k < remaining[v]; k++) {
+                int t = vertexTriangles[firstTriangle[v] + k];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        if (newCache.size() > (size_t)FORSYTH_CACHE_SIZE) {
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(newCache);
+    }
+    copy(output.begin(), output.end(), indices);
+}
+
+// count the vertex cache misses of an index span with a fifo cache
+static size_t countCacheMisses(const GLuint* indices, size_t indexCount, vector<size_t>& cachedAt) {
+    size_t time = 0; // the number of misses so far, a vertex is in the cache if it missed in the last VERTEX_CACHE_SIZE misses
+    fill(cachedAt.begin(), cachedAt.end(), 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        size_t& at = cachedAt[indices[i]];
+        if (at == 0 || time - at >= (size_t)VERTEX_CACHE_SIZE) {
+            time++;
+            at = time;
+        }
+    }
+    return time;
+}
+
+float measureAcmr(const GLuint* indices, size_t indexCount, size_t vertexCount) {
+    if (indexCount < 3) {
+        return 0.0f;
+    }
+    vector<size_t> cachedAt(vertexCount);
+    return (float)countCacheMisses(indices, indexCount, cachedAt) / (indexCount / 3);
+}
+
+float measureMeshAcmr(const vector<GLuint>& indices, const vector<MeshShape>& shapes, size_t vertexCount, int level) {
+    vector<size_t> cachedAt(vertexCount);
+    size_t misses = 0, triangles = 0;
+    for (const MeshShape& shape : shapes) {
+        for (const DrawRange& range : shape.ranges) {
+            const IndexSpan& span = range.lods[level];
+            misses += countCacheMisses(indices.data() + span.firstIndex, span.indexCount, cachedAt);
+            triangles += span.indexCount / 3;
+        }
+    }
+    return triangles > 0 ? (float)misses / triangles : 0.0f;
+}
+
+// a run of triangles that starts with a cold vertex cache, so it can move without costing cache misses
+struct TriangleCluster {
+    size_t first; // first triangle
+    size_t count;
+    float score; // how much the cluster faces out of the mesh
+};
+
+void optimizeOverdraw(const vector<MeshVertex>& vertices, GLuint* indices, size_t indexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // split where the cache misses all the vertices of a triangle
+    vector<TriangleCluster> clusters;
+    vector<size_t> cachedAt(vertices.size(), 0);
+    size_t time = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int c = 0; c < 3; c++) {
+            size_t& at = cachedAt[indices[t * 3 + c]];
+            if (at == 0 || time - at >= (size_t)VERTEX_CACHE_SIZE) {
+                time++;
+                at = time;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) {
+            TriangleCluster cluster = { t, 0, 0.0f };
+            clusters.push_back(cluster);
+        }
+        clusters.back().count++;
+    }
+    if (clusters.size() < 2) {
+        return;
+    }
+
+    // the area weighted centroid of the span
+    double meshCenter[3] = { 0, 0, 0 };
+    double meshArea = 0;
+    vector<double> clusterData(clusters.size() * 7, 0.0); // centroid * area, normal * area, area
+    for (size_t k = 0; k < clusters.size(); k++) {
+        double* data = &clusterData[k * 7];
+        for (size_t t = clusters[k].first; t < clusters[k].first + clusters[k].count; t++) {
+            const GLfloat* p0 = vertices[indices[t * 3]].position;
+            const GLfloat* p1 = vertices[indices[t * 3 + 1]].position;
+            const GLfloat* p2 = vertices[indices[t * 3 + 2]].position;
+            double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            double normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            double area = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]) * 0.5;
+            for (int i = 0; i < 3; i++) {
+                data[i] += (p0[i] + p1[i] + p2[i]) / 3.0 * area;
+                data[3 + i] += normal[i] * 0.5; // the cross product length is twice the area
+            }
+            data[6] += area;
+        }
+        for (int i = 0; i < 3; i++) {
+            meshCenter[i] += data[i];
+        }
+        meshArea += data[6];
+    }
+    if (meshArea <= 0) {
+        return;
+    }
+
+    // clusters that face away from the center are drawn first, they hide the ones inside
+    for (size_t k = 0; k < clusters.size(); k++) {
+        const double* data = &clusterData[k * 7];
+        double normalLength = sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+        if (data[6] <= 0 || normalLength <= 0) {
+            continue;
+        }
+        double score = 0;
+        for (int i = 0; i < 3; i++) {
+            score += (data[i] / data[6] - meshCenter[i] / meshArea) * data[3 + i] / normalLength;
+        }
+        clusters[k].score = (float)score;
+    }
+    stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b) { return a.score > b.score; });
+
+    vector<GLuint> sorted;
+    sorted.reserve(triangleCount * 3);
+    for (const TriangleCluster& cluster : clusters) {
+        sorted.insert(sorted.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+    }
+    copy(sorted.begin(), sorted.end(), indices);
+}
+
+void optimizeVertexFetch(vector<MeshVertex>& vertices, vector<GLuint>& indices) {
+    const GLuint unused = (GLuint)-1;
+    vector<GLuint> remap(vertices.size(), unused);
+    vector<MeshVertex> ordered;
+    ordered.reserve(vertices.size());
+    for (GLuint& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = (GLuint)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+void optimizeMesh(vector<MeshVertex>& vertices, vector<GLuint>& indices, const vector<MeshShape>& shapes) {
+    set<GLuint> optimized; // levels that reuse the previous level share its span
+    for (const MeshShape& shape : shapes) {
+        for (const DrawRange& range : shape.ranges) {
+            for (int level = 0; level < MESH_LOD_LEVELS; level++) {
+                const IndexSpan& span = range.lods[level];
+                if (span.indexCount == 0 || !optimized.insert(span.firstIndex).second) {
+                    continue;
+                }
+                optimizeVertexCache(indices.data() + span.firstIndex, span.indexCount, vertices.size());
+                optimizeOverdraw(vertices, indices.data() + span.firstIndex, span.indexCount);
+            }
+        }
+    }
+    optimizeVertexFetch(vertices, indices);
+}
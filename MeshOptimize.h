@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include "Mesh.h"
+
+using namespace std;
+
+// Import stage that makes the vertex pipeline reuse vertices.
+// The importer writes one vertex per polygon corner; welding merges the identical ones, then the
+// triangles of every draw range are ordered for the post transform vertex cache (Forsyth) and the
+// cache friendly clusters are sorted front to back from the outside in to reduce overdraw.
+
+const int VERTEX_CACHE_SIZE = 16; // the fifo cache size used to measure the ACMR
+
+// merge identical vertices, remapping the indices, returns the new vertex count
+size_t weldVertices(vector<MeshVertex>& vertices, vector<GLuint>& indices);
+
+// reorder the triangles of an index span for the vertex cache (in place)
+void optimizeVertexCache(GLuint* indices, size_t indexCount, size_t vertexCount);
+
+// sort the cache clusters of an index span so the outer triangles are drawn first (in place)
+void optimizeOverdraw(const vector<MeshVertex>& vertices, GLuint* indices, size_t indexCount);
+
+// reorder the vertices by first use so the vertex fetches are sequential, remapping the indices
+void optimizeVertexFetch(vector<MeshVertex>& vertices, vector<GLuint>& indices);
+
+// the average cache miss per triangle of an index span with a fifo cache of VERTEX_CACHE_SIZE vertices
+float measureAcmr(const GLuint* indices, size_t indexCount, size_t vertexCount);
+
+// the ACMR of a level of detail of all the draw ranges
+float measureMeshAcmr(const vector<GLuint>& indices, const vector<MeshShape>& shapes, size_t vertexCount, int level);
+
+// optimize every level of every draw range for the vertex cache and overdraw, then the vertex fetches
+void optimizeMesh(vector<MeshVertex>& vertices, vector<GLuint>& indices, const vector<MeshShape>& shapes);
@@ -1,19 +1,27 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include "ObjectGL.h"
+#include "AssetLoader.h"
+#include "MeshLod.h"
+#include "MeshOptimize.h"
 #include <cmath> // Include for sin() function
+#include <cassert>
+#include <cstddef>
+#include <chrono>
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+bool ObjectGL::lodEnabled = true;
+bool ObjectGL::cullingEnabled = true;
+CullStats ObjectGL::cullStats;
+bool ObjectGL::staticBatching = true;
+
 
 
 ObjectGL::ObjectGL(string inputfile, GLfloat PosX, GLfloat PosY, GLfloat PosZ, GLfloat scale,
     glm::vec3 upVector, glm::vec3 towardVector, GLfloat angle) {
-    if (!FileExists(inputfile)) {
-        // Append default objects dir.
-        inputfile = OBJECTS_DIR + "/" + inputfile;
-    }
+    inputfile = resolvePath(inputfile);
     this->inputfile = inputfile;
     setPosition(PosX, PosY, PosZ);
     this->upVector = upVector;
@@ -21,189 +29,535 @@ ObjectGL::ObjectGL(string inputfile, GLfloat PosX, GLfloat PosY, GLfloat PosZ, G
     this->angle = angle;
     this->scale = scale;
 
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-
-    std::string warn;
-    std::string err;
-
-    string base_dir = GetBaseDir(inputfile);
-    if (base_dir.empty()) {
-        base_dir = ".";
+    // use the model the asset loader preloaded, or load it now
+    shared_ptr<LoadedModel> model = AssetLoader::instance().takeModel(this->inputfile);
+    if (!model) {
+        model = loadModel(this->inputfile);
     }
-#ifdef _WIN32
-    base_dir += "\\";
-#else
-    base_dir += "/";
-#endif
+    if (!model->mesh) {
+        exit(1); // the import reported why, exit here rather than on the loader thread
+    }
+    this->mesh = model->mesh;
 
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, this->inputfile.c_str(), base_dir.c_str()); // load the .obj file
+    this->shapeOpOffsets.assign(this->mesh->shapes.size() + 2, 0); // no operations yet (slot 0 is the whole object)
 
-    if (!warn.empty()) {
-        std::cout << "WARN: " << warn << std::endl;
+    TimelineScope scope(this->inputfile, "upload");
+    loadTextures(model->textures);
+    resolveMaterials();
+    uploadMesh();
+}
+
+string ObjectGL::resolvePath(const string& inputfile) {
+    if (!FileExists(inputfile)) {
+        // Append default objects dir.
+        return OBJECTS_DIR + "/" + inputfile;
     }
+    return inputfile;
+}
 
-    if (!err.empty()) {
-        std::cerr << "ERROR: " << err << std::endl;
+shared_ptr<LoadedModel> ObjectGL::loadModel(const string& inputfile) {
+    shared_ptr<LoadedModel> model = make_shared<LoadedModel>();
+    {
+        TimelineScope scope(inputfile, "mesh");
+        model->mesh = loadMesh(inputfile);
+    }
+    if (!model->mesh) {
+        return model; // failed, the object exits on the main thread
     }
 
-    if (!ret) {
-        exit(1);
+    // decode every texture once
+    string base_dir = GetObjectDir(inputfile);
+    map<string, bool> decoded;
+    for (const MeshMaterialInfo& material : model->mesh->materials) {
+        if (material.textureName.empty() || decoded[material.textureName]) {
+            continue;
+        }
+        decoded[material.textureName] = true;
+        TimelineScope scope(inputfile, "decode " + material.textureName);
+        DecodedTexture texture = TextureRegistry::instance().decode(findTextureFile(base_dir, material.textureName));
+        texture.name = material.textureName;
+        model->textures.push_back(texture);
     }
+    return model;
+}
 
-    this->attrib = attrib;
-    this->shapes = shapes;
-    this->materials = materials;
+shared_ptr<MeshData> ObjectGL::loadMesh(const string& inputfile) {
+    shared_ptr<MeshData> mesh = make_shared<MeshData>();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double importMilliseconds = 0;
+
+    // use the cache written by a previous run when it matches the .obj file
+    if (loadMeshCache(inputfile, *mesh, importMilliseconds)) {
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        recordMeshLoad(inputfile, *mesh, true, milliseconds, importMilliseconds);
+        return mesh;
+    }
 
-    for (size_t s = 0; s < this->shapes.size(); s++) {
-        this->shapesTasks[this->shapes[s].name] = vector<function<void()>>(); // insert empty tasks vectors
+    if (!importObj(inputfile, *mesh)) {
+        return NULL;
     }
+    importMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    recordMeshLoad(inputfile, *mesh, false, importMilliseconds, importMilliseconds);
+    saveMeshCache(inputfile, *mesh, importMilliseconds);
+    return mesh;
+}
 
+void ObjectGL::loadTextures(const vector<DecodedTexture>& decoded) {
     // create textures
     this->textures[""] = 0; // if no given texture don't use texture
-    GLuint texture_id;
-    string texture_filename;
-    // for each material
-    for (size_t m = 0; m < materials.size(); m++) {
-        tinyobj::material_t* mp = &materials[m];
-        texture_filename = mp->diffuse_texname;
-        // find texture file
-        if (this->textures.find(texture_filename) == this->textures.end()) {
-            if (FileExists(base_dir + mp->diffuse_texname)) {
-                // Append base dir.
-                texture_filename = base_dir + mp->diffuse_texname;
-                std::cout << "Texture name: " << texture_filename  << std::endl;
-
-                
-            }
-            texture_id = create_texture(texture_filename); // create the texture in OpenGL
-            this->textures.insert(make_pair(mp->diffuse_texname, texture_id)); // insert the texture id to the textures map
+    for (const DecodedTexture& texture : decoded) {
+        if (this->textures.find(texture.name) == this->textures.end()) {
+            this->textures.insert(make_pair(texture.name, TextureRegistry::instance().acquire(texture))); // shared by every object using the file
         }
     }
 }
 
+string ObjectGL::findTextureFile(const string& objectDir, const string& textureName) {
+    if (FileExists(objectDir + textureName)) {
+        // Append base dir.
+        return objectDir + textureName;
+    }
+    return textureName;
+}
+
 void ObjectGL::draw() {
+    if (this->batched && staticBatching) {
+        this->trianglesDrawn = 0;
+        return; // drawn by the static batch
+    }
+    this->trianglesDrawn = 0;
     glPushMatrix();
 
     glTranslatef(PosX, PosY, PosZ); // Move the object to the desired position
     glRotatef(angle, this->upVector.x, this->upVector.y, this->upVector.z); // Rotate the object
     glScalef(scale, scale, scale); // Scale the object
 
-    // Call all the tasks in the GLOBAL tasks vector
-    for (function<void()> task : this->shapesTasks["GLOBAL"]) {
-        task();
+    // Apply the operations of the whole object
+    int objectMaterial = -1;
+    int currentMaterial = NO_MATERIAL;
+    if (!applyShapeOps(0, objectMaterial, currentMaterial)) {
+        glPopMatrix();
+        return; // hidden
+    }
+
+    // Skip the whole object when its bounds are out of the view
+    glm::mat4 clip = Frustum::currentClipMatrix();
+    Frustum frustum = Frustum::fromClipMatrix(clip); // in the object space
+    if (cullingEnabled && !frustum.contains(this->mesh->bounds)) {
+        cullStats.objectsCulled++;
+        cullStats.shapesCulled += (int)this->mesh->shapes.size();
+        glPopMatrix();
+        return;
     }
+    cullStats.objectsDrawn++;
+
+    selectLod(clip);
+    bindMesh();
 
     // Loop over shapes
-    for (size_t s = 0; s < this->shapes.size(); s++) {
+    for (size_t s = 0; s < this->mesh->shapes.size(); s++) {
         glPushMatrix();
 
-        // Call all the shape's tasks
-        for (function<void()> task : this->shapesTasks[this->shapes[s].name]) {
-            task();
+        // Apply the shape's operations
+        int materialOverride = objectMaterial;
+        if (!applyShapeOps(s + 1, materialOverride, currentMaterial)) {
+            glPopMatrix();
+            continue; // hidden
+        }
+
+        // Skip the shape when it is out of the view (its operations may have moved it)
+        if (cullingEnabled) {
+            bool moved = this->shapeOpOffsets[s + 1] != this->shapeOpOffsets[s + 2];
+            if (!(moved ? Frustum::current() : frustum).contains(this->mesh->shapes[s].bounds)) {
+                cullStats.shapesCulled++;
+                glPopMatrix();
+                continue;
+            }
+        }
+        cullStats.shapesDrawn++;
+
+        // Draw each material range of the shape with a single call, skipping redundant state changes
+        for (const DrawRange& range : this->mesh->shapes[s].ranges) {
+            if (materialOverride >= 0) {
+                if (currentMaterial != -3 - materialOverride) { // overrides use the ids under NO_MATERIAL
+                    applyMaterial(this->materialOverrides[materialOverride]);
+                    currentMaterial = -3 - materialOverride;
+                }
+            }
+            else if (range.materialId != currentMaterial) {
+                applyMaterial(range.material);
+                currentMaterial = range.materialId;
+            }
+            const IndexSpan& span = range.lods[this->lodLevel];
+            glDrawElements(GL_TRIANGLES, span.indexCount, GL_UNSIGNED_INT, indexData(span.firstIndex));
+            this->trianglesDrawn += span.indexCount / 3;
+        }
+        glPopMatrix();
+    }
+
+    unbindMesh();
+
+    // Clear texture
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopMatrix();
+}
+
+ObjectGL::~ObjectGL() {
+    for (const pair<const string, GLuint>& texture : this->textures) {
+        if (texture.second != 0) {
+            TextureRegistry::instance().release(texture.second);
+        }
+    }
+    if (this->vertexBuffer != 0) {
+        pglDeleteBuffers(1, &this->vertexBuffer);
+    }
+    if (this->indexBuffer != 0) {
+        pglDeleteBuffers(1, &this->indexBuffer);
+    }
+}
+
+// the bounds of the vertices used by some index spans
+static MeshBounds computeBounds(const vector<MeshVertex>& vertices, const vector<GLuint>& indices, const vector<IndexSpan>& spans) {
+    glm::vec3 lower(numeric_limits<float>::max()), upper(-numeric_limits<float>::max());
+    bool empty = true;
+    for (const IndexSpan& span : spans) {
+        for (GLsizei i = 0; i < span.indexCount; i++) {
+            glm::vec3 position = glm::make_vec3(vertices[indices[span.firstIndex + i]].position);
+            lower = glm::min(lower, position);
+            upper = glm::max(upper, position);
+            empty = false;
+        }
+    }
+    if (empty) {
+        lower = upper = glm::vec3(0);
+    }
+
+    // sphere around the center of the box
+    glm::vec3 center = (lower + upper) * 0.5f;
+    float radius = 0;
+    for (const IndexSpan& span : spans) {
+        for (GLsizei i = 0; i < span.indexCount; i++) {
+            radius = max(radius, glm::length(glm::make_vec3(vertices[indices[span.firstIndex + i]].position) - center));
+        }
+    }
+
+    MeshBounds bounds = {
+        { lower.x, lower.y, lower.z },
+        { upper.x, upper.y, upper.z },
+        { center.x, center.y, center.z },
+        radius
+    };
+    return bounds;
+}
+
+bool ObjectGL::importObj(const string& inputfile, MeshData& mesh) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+
+    std::string warn;
+    std::string err;
+
+    string base_dir = GetObjectDir(inputfile);
+
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, inputfile.c_str(), base_dir.c_str()); // load the .obj file
+
+    if (!warn.empty()) {
+        std::cout << "WARN: " << warn << std::endl;
+    }
+
+    if (!err.empty()) {
+        std::cerr << "ERROR: " << err << std::endl;
+    }
+
+    if (!ret) {
+        return false;
+    }
+
+    // keep only what drawing needs from the materials
+    mesh.materials.resize(materials.size());
+    for (size_t m = 0; m < materials.size(); m++) {
+        MeshMaterial& material = mesh.materials[m].material;
+        for (int i = 0; i < 3; i++) {
+            material.diffuse[i] = materials[m].diffuse[i];
+            material.specular[i] = materials[m].specular[i];
+            material.emission[i] = materials[m].emission[i];
         }
+        material.diffuse[3] = materials[m].dissolve;
+        material.specular[3] = 1.0f;
+        material.emission[3] = 1.0f;
+        material.shininess = materials[m].shininess;
+        material.texture = 0;
+        mesh.materials[m].textureName = materials[m].diffuse_texname;
+    }
+
+    vector<MeshVertex> vertices; // the triangulated vertices of all the shapes
+    vector<GLuint> indices; // the triangles indices to vertices
+    mesh.shapes.clear();
+
+    for (size_t s = 0; s < shapes.size(); s++) {
+        MeshShape meshShape;
+        meshShape.name = shapes[s].name;
+        map<int, vector<GLuint>> materialTriangles; // the shape triangles grouped by material id
 
         // Loop over faces (polygons)
         size_t index_offset = 0;
-        for (size_t f = 0; f < this->shapes[s].mesh.num_face_vertices.size(); f++) {
+        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
+            int fv = shapes[s].mesh.num_face_vertices[f];
+            if (fv < 3) {
+                index_offset += fv; // skip points and lines
+                continue;
+            }
+
             // Get material
-            int current_material_id = this->shapes[s].mesh.material_ids[f];
-            if (current_material_id < 0 || current_material_id >= this->materials.size()) {
-                // std::cerr << "Material index out of range: " << current_material_id << std::endl;
+            int current_material_id = shapes[s].mesh.material_ids[f];
+            if (current_material_id < 0 || current_material_id >= (int)materials.size()) {
                 current_material_id = -1; // Indicate no material
             }
 
-            // If the material index is valid, set the material properties
-            if (current_material_id != -1) {
-                tinyobj::material_t* material = &this->materials[current_material_id];
+            GLuint firstVertex = (GLuint)vertices.size();
+            bool missingNormal = false;
+
+            // Loop over vertices in the face
+            for (int v = 0; v < fv; v++) {
+                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
+                MeshVertex vertex = {};
 
-                // Bind texture
-                string diffuse_texname = material->diffuse_texname;
-                if (this->textures.find(diffuse_texname) == this->textures.end()) {
-                    std::cerr << "Texture not found: " << diffuse_texname << std::endl;
-                    glBindTexture(GL_TEXTURE_2D, 0); // Bind default texture
+                // Get vertex
+                if (idx.vertex_index >= 0 && 3 * idx.vertex_index + 2 < (int)attrib.vertices.size()) {
+                    vertex.position[0] = attrib.vertices[3 * idx.vertex_index + 0];
+                    vertex.position[1] = attrib.vertices[3 * idx.vertex_index + 1];
+                    vertex.position[2] = attrib.vertices[3 * idx.vertex_index + 2];
                 }
                 else {
-                    glBindTexture(GL_TEXTURE_2D, this->textures[diffuse_texname]);
+                    std::cerr << "Vertex index out of range: " << idx.vertex_index << std::endl;
                 }
 
-                // Set material color settings
-                glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, material->diffuse);
-                glMaterialfv(GL_FRONT, GL_SPECULAR, material->specular);
-                glMaterialfv(GL_FRONT, GL_EMISSION, material->emission);
-                glMaterialf(GL_FRONT, GL_SHININESS, material->shininess);
-            }
-            else {
-                // Use default material properties if no valid material is assigned
-                GLfloat default_diffuse[] = { 0.8f, 0.8f, 0.8f, 1.0f };
-                GLfloat default_specular[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-                GLfloat default_emission[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-                GLfloat default_shininess = 0.0f;
-
-                glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, default_diffuse);
-                glMaterialfv(GL_FRONT, GL_SPECULAR, default_specular);
-                glMaterialfv(GL_FRONT, GL_EMISSION, default_emission);
-                glMaterialf(GL_FRONT, GL_SHININESS, default_shininess);
-                glBindTexture(GL_TEXTURE_2D, 0); // Bind default texture
-            }
-
-            int fv = this->shapes[s].mesh.num_face_vertices[f];
-
-            glBegin(GL_POLYGON);
-
-            // Loop over vertices in the face
-            for (size_t v = 0; v < fv; v++) {
-                tinyobj::index_t idx = this->shapes[s].mesh.indices[index_offset + v];
-
                 // Get normal
-                if (idx.normal_index != -1) {
-                    if (3 * idx.normal_index + 2 < this->attrib.normals.size()) {
-                        tinyobj::real_t nx = this->attrib.normals[3 * idx.normal_index + 0];
-                        tinyobj::real_t ny = this->attrib.normals[3 * idx.normal_index + 1];
-                        tinyobj::real_t nz = this->attrib.normals[3 * idx.normal_index + 2];
-                        glNormal3f(nx, ny, nz);
-                    }
-                    else {
+                if (idx.normal_index >= 0 && 3 * idx.normal_index + 2 < (int)attrib.normals.size()) {
+                    vertex.normal[0] = attrib.normals[3 * idx.normal_index + 0];
+                    vertex.normal[1] = attrib.normals[3 * idx.normal_index + 1];
+                    vertex.normal[2] = attrib.normals[3 * idx.normal_index + 2];
+                }
+                else {
+                    if (idx.normal_index != -1) {
                         std::cerr << "Normal index out of range: " << idx.normal_index << std::endl;
                     }
+                    missingNormal = true;
                 }
 
                 // Get texture coordinates
-                if (idx.texcoord_index != -1) {
-                    if (2 * idx.texcoord_index + 1 < this->attrib.texcoords.size()) {
-                        tinyobj::real_t tx = this->attrib.texcoords[2 * idx.texcoord_index + 0];
-                        tinyobj::real_t ty = this->attrib.texcoords[2 * idx.texcoord_index + 1];
-                        glTexCoord2f(tx, ty);
-                    }
-                    else {
-                        std::cerr << "Texcoord index out of range: " << idx.texcoord_index << std::endl;
-                    }
+                if (idx.texcoord_index >= 0 && 2 * idx.texcoord_index + 1 < (int)attrib.texcoords.size()) {
+                    vertex.texcoord[0] = attrib.texcoords[2 * idx.texcoord_index + 0];
+                    vertex.texcoord[1] = attrib.texcoords[2 * idx.texcoord_index + 1];
+                }
+                else if (idx.texcoord_index != -1) {
+                    std::cerr << "Texcoord index out of range: " << idx.texcoord_index << std::endl;
                 }
 
-                // Get vertex
-                if (idx.vertex_index != -1) {
-                    if (3 * idx.vertex_index + 2 < this->attrib.vertices.size()) {
-                        tinyobj::real_t vx = this->attrib.vertices[3 * idx.vertex_index + 0];
-                        tinyobj::real_t vy = this->attrib.vertices[3 * idx.vertex_index + 1];
-                        tinyobj::real_t vz = this->attrib.vertices[3 * idx.vertex_index + 2];
-                        glVertex3f(vx, vy, vz);
-                    }
-                    else {
-                        std::cerr << "Vertex index out of range: " << idx.vertex_index << std::endl;
-                    }
+                vertices.push_back(vertex);
+            }
+
+            // Faces without normals get a flat face normal
+            if (missingNormal) {
+                glm::vec3 p0 = glm::make_vec3(vertices[firstVertex].position);
+                glm::vec3 p1 = glm::make_vec3(vertices[firstVertex + 1].position);
+                glm::vec3 p2 = glm::make_vec3(vertices[firstVertex + 2].position);
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                if (glm::length(normal) > 0.0f) {
+                    normal = glm::normalize(normal);
+                }
+                for (int v = 0; v < fv; v++) {
+                    vertices[firstVertex + v].normal[0] = normal.x;
+                    vertices[firstVertex + v].normal[1] = normal.y;
+                    vertices[firstVertex + v].normal[2] = normal.z;
                 }
             }
-            glEnd();
+
+            // Triangulate the polygon as a fan around its first vertex
+            vector<GLuint>& triangles = materialTriangles[current_material_id];
+            for (int v = 1; v + 1 < fv; v++) {
+                triangles.push_back(firstVertex);
+                triangles.push_back(firstVertex + v);
+                triangles.push_back(firstVertex + v + 1);
+            }
 
             index_offset += fv;
         }
-        glPopMatrix();
+
+        // Store the triangles of each material contiguously so every material is one draw range
+        for (map<int, vector<GLuint>>::iterator it = materialTriangles.begin(); it != materialTriangles.end(); ++it) {
+            DrawRange range = {};
+            range.lods[0].firstIndex = (GLuint)indices.size();
+            range.lods[0].indexCount = (GLsizei)it->second.size();
+            range.materialId = it->first;
+            indices.insert(indices.end(), it->second.begin(), it->second.end());
+            meshShape.ranges.push_back(range);
+        }
+        mesh.shapes.push_back(meshShape);
     }
 
-    // Clear texture
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glPopMatrix();
+    // Share the vertices that are equal in every attribute
+    mesh.optimizeStats.importedVertices = vertices.size();
+    mesh.optimizeStats.acmrBefore = measureMeshAcmr(indices, mesh.shapes, vertices.size(), 0);
+    weldVertices(vertices, indices);
+
+    // Simplified levels of detail, drawn when the object is small on screen
+    buildMeshLods(vertices, indices, mesh.shapes);
+
+    // Order the triangles for the vertex cache and overdraw, and the vertices for fetching
+    optimizeMesh(vertices, indices, mesh.shapes);
+    mesh.optimizeStats.acmrAfter = measureMeshAcmr(indices, mesh.shapes, vertices.size(), 0);
+
+    // Bounds of the whole mesh and of every shape, for culling and picking the level of detail
+    vector<IndexSpan> spans;
+    for (MeshShape& meshShape : mesh.shapes) {
+        vector<IndexSpan> shapeSpans;
+        for (const DrawRange& range : meshShape.ranges) {
+            shapeSpans.push_back(range.lods[0]);
+        }
+        meshShape.bounds = computeBounds(vertices, indices, shapeSpans);
+        spans.insert(spans.end(), shapeSpans.begin(), shapeSpans.end());
+    }
+    mesh.bounds = computeBounds(vertices, indices, spans);
+
+    mesh.setGeometry(std::move(vertices), std::move(indices));
+    return true;
+}
+
+void ObjectGL::uploadMesh() {
+    if (!loadGLExtensions() || this->mesh->vertexCount == 0) {
+        return; // draw from the client side arrays
+    }
+
+    pglGenBuffers(1, &this->vertexBuffer);
+    pglBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    pglBufferData(GL_ARRAY_BUFFER, this->mesh->vertexCount * sizeof(MeshVertex), this->mesh->vertices, GL_STATIC_DRAW);
+
+    pglGenBuffers(1, &this->indexBuffer);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer);
+    pglBufferData(GL_ELEMENT_ARRAY_BUFFER, this->mesh->indexCount * sizeof(GLuint), this->mesh->indices, GL_STATIC_DRAW);
+
+    pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void ObjectGL::bindMesh() {
+    const char* base = NULL; // offsets are relative to the bound buffer
+    if (this->vertexBuffer != 0) {
+        pglBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer);
+    }
+    else {
+        base = reinterpret_cast<const char*>(this->mesh->vertices);
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), base + offsetof(MeshVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(MeshVertex), base + offsetof(MeshVertex, normal));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex), base + offsetof(MeshVertex, texcoord));
+}
+
+void ObjectGL::unbindMesh() {
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    // ImGui draws from client side arrays, so no buffer may stay bound
+    if (this->vertexBuffer != 0) {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+float ObjectGL::projectedRadius(const glm::mat4& clip) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glm::vec4 center = clip * glm::vec4(glm::make_vec3(this->mesh->bounds.center), 1.0f);
+    if (center.w <= 0.0f) {
+        return numeric_limits<float>::max(); // the camera is inside the object
+    }
+    // the y row holds the focal length times the object scale (the camera and model are not skewed)
+    float focal = glm::length(glm::vec3(clip[0][1], clip[1][1], clip[2][1]));
+    return this->mesh->bounds.radius * focal / center.w * viewport[3] * 0.5f;
+}
+
+void ObjectGL::selectLod(const glm::mat4& clip) {
+    this->lodLevel = lodEnabled ? nextLodLevel(projectedRadius(clip), this->lodLevel) : 0;
+}
+
+int ObjectGL::nextLodLevel(float radius, int level) {
+    // move one way only when the size is past the threshold by the hysteresis, so the level does not flicker
+    while (level < MESH_LOD_LEVELS - 1 && radius < LOD_SCREEN_RADIUS[level] * (1 - LOD_HYSTERESIS)) {
+        level++;
+    }
+    while (level > 0 && radius > LOD_SCREEN_RADIUS[level - 1] * (1 + LOD_HYSTERESIS)) {
+        level--;
+    }
+    return level;
+}
+
+GLsizei ObjectGL::triangleCount(int level) const {
+    GLsizei count = 0;
+    for (const MeshShape& shape : this->mesh->shapes) {
+        for (const DrawRange& range : shape.ranges) {
+            count += range.lods[level].indexCount / 3;
+        }
+    }
+    return count;
+}
+
+const GLvoid* ObjectGL::indexData(GLuint firstIndex) {
+    if (this->indexBuffer != 0) {
+        return bufferOffset(firstIndex * sizeof(GLuint));
+    }
+    return this->mesh->indices + firstIndex;
+}
+
+void ObjectGL::resolveMaterials() {
+    // Default material properties if no valid material is assigned
+    MeshMaterial defaultMaterial = {
+        { 0.8f, 0.8f, 0.8f, 1.0f }, // diffuse
+        { 0.0f, 0.0f, 0.0f, 1.0f }, // specular
+        { 0.0f, 0.0f, 0.0f, 1.0f }, // emission
+        0.0f, // shininess
+        0 // no texture
+    };
+
+    for (MeshShape& meshShape : this->mesh->shapes) {
+        for (DrawRange& range : meshShape.ranges) {
+            if (range.materialId == -1) {
+                range.material = defaultMaterial;
+                continue;
+            }
+
+            const MeshMaterialInfo& material = this->mesh->materials[range.materialId];
+            range.material = material.material;
+
+            // Find the texture once instead of on every draw
+            map<string, GLuint>::iterator texture = this->textures.find(material.textureName);
+            if (texture == this->textures.end()) {
+                std::cerr << "Texture not found: " << material.textureName << std::endl;
+                range.material.texture = 0; // Bind default texture
+            }
+            else {
+                range.material.texture = texture->second;
+            }
+        }
+    }
+}
+
+void ObjectGL::applyMaterial(const MeshMaterial& material) {
+    glBindTexture(GL_TEXTURE_2D, material.texture);
+
+    // Set material color settings
+    glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, material.diffuse);
+    glMaterialfv(GL_FRONT, GL_SPECULAR, material.specular);
+    glMaterialfv(GL_FRONT, GL_EMISSION, material.emission);
+    glMaterialf(GL_FRONT, GL_SHININESS, material.shininess);
 }
 
 // Set the object's position
@@ -220,74 +574,155 @@ void ObjectGL::walk(GLfloat distance) {
     setPosition(x, y, z);
 }
 
-void ObjectGL::addTask(function<void()> func, string shape) {
-    this->shapesTasks[shape].push_back(func); // push the tasks to the vector
+int ObjectGL::findShape(const string& name) const {
+    if (name == "GLOBAL") {
+        return GLOBAL_SHAPE;
+    }
+    for (size_t s = 0; s < this->mesh->shapes.size(); s++) {
+        if (this->mesh->shapes[s].name == name) {
+            return (int)s;
+        }
+    }
+    std::cerr << "Shape not found: " << name << std::endl;
+    return NO_SHAPE;
 }
 
-void ObjectGL::rotate(GLfloat angle) {
-    float rad_angle = (angle / 180) * glm::pi<float>(); // use radians
-    glm::mat4 rotationMat(1);
-    rotationMat = glm::rotate(rotationMat, rad_angle, this->upVector);
-    this->towardVector = glm::vec3(rotationMat * glm::vec4(this->towardVector, 1.0)); // rotate towardVector
-    this->angle += angle;
+int ObjectGL::addOp(const ShapeOp& op, int shape) {
+    if (shape == NO_SHAPE) {
+        return -1;
+    }
+    // the operations of every slot are contiguous, so insert at the end of the slot and shift the next slots
+    size_t slot = shape + 1;
+    this->shapeOps.insert(this->shapeOps.begin() + this->shapeOpOffsets[slot + 1], op);
+    for (size_t i = slot + 1; i < this->shapeOpOffsets.size(); i++) {
+        this->shapeOpOffsets[i]++;
+    }
+    return (int)(this->shapeOpOffsets[slot + 1] - this->shapeOpOffsets[slot]) - 1;
 }
 
-GLuint ObjectGL::create_texture(string texture_filename) {
-    if (!FileExists(texture_filename)) {
-        // Append textures dir.
-        texture_filename = TEXTURES_DIR + "/" + texture_filename;
-        if (!FileExists(texture_filename)) {
-            std::cerr << "Unable to find texture file: " << texture_filename << std::endl;
-            exit(1);
-        }
+ShapeOp* ObjectGL::shapeOp(int shape, int index) {
+    size_t slot = shape + 1;
+    if (shape == NO_SHAPE || index < 0 || this->shapeOpOffsets[slot] + index >= this->shapeOpOffsets[slot + 1]) {
+        return NULL;
     }
-    std::cout << "Loading texture: " << texture_filename << std::endl;
+    return &this->shapeOps[this->shapeOpOffsets[slot] + index];
+}
 
-    GLuint texture_id;
-    int w, h, comp;
-    unsigned char* image = stbi_load(texture_filename.c_str(), &w, &h, &comp, STBI_default);
-    if (!image) {
-        std::cerr << "Failed to load texture: " << texture_filename << std::endl;
-        exit(1);
-    }
+int ObjectGL::addMaterialOverride(const MeshMaterial& material, int shape) {
+    ShapeOp op = { SHAPE_MATERIAL, { 0, 0, 0, 0 }, (int)this->materialOverrides.size() };
+    this->materialOverrides.push_back(material);
+    return addOp(op, shape);
+}
 
-    std::cout << "Texture details - Width: " << w << ", Height: " << h << ", Components: " << comp << std::endl;
+void ObjectGL::addTask(function<void()> func, string shape) {
+    ShapeOp op = { SHAPE_CALLBACK, { 0, 0, 0, 0 }, (int)this->callbacks.size() };
+    this->callbacks.push_back(func);
+    addOp(op, findShape(shape));
+}
 
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+bool ObjectGL::applyShapeOps(size_t slot, int& materialOverride, int& currentMaterial) {
+    const ShapeOp* op = this->shapeOps.data() + this->shapeOpOffsets[slot];
+    const ShapeOp* end = this->shapeOps.data() + this->shapeOpOffsets[slot + 1];
+    for (; op != end; ++op) {
+        switch (op->type) {
+        case SHAPE_TRANSLATE:
+            glTranslatef(op->values[0], op->values[1], op->values[2]);
+            break;
+        case SHAPE_ROTATE:
+            glRotatef(op->values[0], op->values[1], op->values[2], op->values[3]);
+            break;
+        case SHAPE_SCALE:
+            glScalef(op->values[0], op->values[1], op->values[2]);
+            break;
+        case SHAPE_MATERIAL:
+            materialOverride = op->index;
+            break;
+        case SHAPE_VISIBLE:
+            if (op->values[0] == 0) {
+                return false;
+            }
+            break;
+        case SHAPE_CALLBACK:
+            this->callbacks[op->index]();
+            currentMaterial = NO_MATERIAL; // a callback may have changed the material
+            break;
+        }
+    }
+    return true;
+}
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+glm::mat4 ObjectGL::modelMatrix() const {
+    glm::mat4 model = glm::translate(glm::mat4(1), glm::vec3(this->PosX, this->PosY, this->PosZ));
+    model = glm::rotate(model, glm::radians(this->angle), this->upVector);
+    return glm::scale(model, glm::vec3(this->scale));
+}
 
-    GLenum format = (comp == 3) ? GL_RGB : (comp == 4) ? GL_RGBA : 0;
-    if (format == 0) {
-        std::cerr << "Unsupported image format: " << comp << " components" << std::endl;
-        stbi_image_free(image);
-        assert(0);
-    }
+void ObjectGL::worldTriangles(vector<glm::vec3>& corners) const {
+    appendTriangles(glm::mat4(1), corners);
+}
 
-    if (w % 4 != 0) {
-        std::cerr << "Warning: Texture width is not a multiple of 4, which may cause issues with some drivers." << std::endl;
+void ObjectGL::appendTriangles(const glm::mat4& placement, vector<glm::vec3>& corners) const {
+    glm::mat4 global;
+    int materialOverride = -1;
+    if (!shapeTransform(0, global, materialOverride)) {
+        return;
     }
-    if (h % 4 != 0) {
-        std::cerr << "Warning: Texture height is not a multiple of 4, which may cause issues with some drivers." << std::endl;
+    glm::mat4 model = modelMatrix() * global * placement;
+    for (size_t s = 0; s < this->mesh->shapes.size(); s++) {
+        glm::mat4 local;
+        if (!shapeTransform(s + 1, local, materialOverride)) {
+            continue;
+        }
+        glm::mat4 world = model * local;
+        for (const DrawRange& range : this->mesh->shapes[s].ranges) {
+            const IndexSpan& span = range.lods[0];
+            for (GLsizei i = 0; i < span.indexCount; i++) {
+                const MeshVertex& vertex = this->mesh->vertices[this->mesh->indices[span.firstIndex + i]];
+                corners.push_back(glm::vec3(world * glm::vec4(glm::make_vec3(vertex.position), 1.0f)));
+            }
+        }
     }
-    glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, image);
+}
 
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after glTexImage2D: " << error << std::endl;
-        stbi_image_free(image);
-        exit(1);
+bool ObjectGL::shapeTransform(size_t slot, glm::mat4& matrix, int& materialOverride) const {
+    matrix = glm::mat4(1);
+    for (size_t i = this->shapeOpOffsets[slot]; i < this->shapeOpOffsets[slot + 1]; i++) {
+        const ShapeOp& op = this->shapeOps[i];
+        switch (op.type) {
+        case SHAPE_TRANSLATE:
+            matrix = glm::translate(matrix, glm::vec3(op.values[0], op.values[1], op.values[2]));
+            break;
+        case SHAPE_ROTATE:
+            matrix = glm::rotate(matrix, glm::radians(op.values[0]), glm::vec3(op.values[1], op.values[2], op.values[3]));
+            break;
+        case SHAPE_SCALE:
+            matrix = glm::scale(matrix, glm::vec3(op.values[0], op.values[1], op.values[2]));
+            break;
+        case SHAPE_VISIBLE:
+            if (op.values[0] == 0) {
+                return false;
+            }
+            break;
+        case SHAPE_MATERIAL:
+            materialOverride = op.index;
+            break;
+        case SHAPE_CALLBACK:
+            break; // callbacks only run in draw()
+        }
     }
+    return true;
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(image);
+void ObjectGL::rotate(GLfloat angle) {
+    float rad_angle = (angle / 180) * glm::pi<float>(); // use radians
+    glm::mat4 rotationMat(1);
+    rotationMat = glm::rotate(rotationMat, rad_angle, this->upVector);
+    this->towardVector = glm::vec3(rotationMat * glm::vec4(this->towardVector, 1.0)); // rotate towardVector
+    this->angle += angle;
+}
 
-    std::cout << "Texture loaded successfully: " << texture_id << std::endl;
-    return texture_id;
+GLuint ObjectGL::create_texture(string texture_filename) {
+    return TextureRegistry::instance().acquire(texture_filename);
 }
 
 bool FileExists(const std::string& abs_filename) {
@@ -301,6 +736,19 @@ string GetBaseDir(const std::string& filepath) {
     return "";
 }
 
+string GetObjectDir(const std::string& filepath) {
+    string base_dir = GetBaseDir(filepath);
+    if (base_dir.empty()) {
+        base_dir = ".";
+    }
+#ifdef _WIN32
+    base_dir += "\\";
+#else
+    base_dir += "/";
+#endif
+    return base_dir;
+}
+
 void ObjectGL::setVibration(bool enable, float initialPos) {
     vibrating = enable;
     
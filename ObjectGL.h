@@ -13,6 +13,13 @@
 #include <functional>
 #include <vector>
 #include <map>
+#include <memory>
+
+#include "GLExtensions.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "TextureRegistry.h"
+#include "Frustum.h"
 
 using namespace std;
 
@@ -20,20 +27,81 @@ bool FileExists(const std::string& abs_filename); //check if a file exists in th
 
 string GetBaseDir(const std::string& filepath); // get the base directory of a file
 
+string GetObjectDir(const std::string& filepath); // get the base directory of a file with a trailing separator ("./" if none)
+
 const string OBJECTS_DIR = "objects"; // the deafult directory of the .obj files
 const string TEXTURES_DIR = "textures"; // the deafult directory of the textures files
 
+const float LOD_SCREEN_RADIUS[MESH_LOD_LEVELS - 1] = { 120, 60, 30 }; // the projected radius (pixels) under which each next level of detail is drawn
+const float LOD_HYSTERESIS = 0.15f; // how far (relative) past a threshold the size must be to switch level
+
+// the kinds of operations applied before drawing a shape
+enum ShapeOpType {
+	SHAPE_TRANSLATE, // glTranslatef(values[0], values[1], values[2])
+	SHAPE_ROTATE, // glRotatef(values[0], values[1], values[2], values[3]) (angle then axis)
+	SHAPE_SCALE, // glScalef(values[0], values[1], values[2])
+	SHAPE_MATERIAL, // draw the shape with the material override number index
+	SHAPE_VISIBLE, // skip the shape when values[0] is 0
+	SHAPE_CALLBACK // call the callback number index (may change any opengl state)
+};
+
+// an operation applied before drawing a shape, plain data so the operations can be stored in one array
+struct ShapeOp {
+	ShapeOpType type;
+	GLfloat values[4];
+	int index; // material override or callback number
+};
+
+inline ShapeOp translateOp(GLfloat x, GLfloat y, GLfloat z) { ShapeOp op = { SHAPE_TRANSLATE, { x, y, z, 0 }, 0 }; return op; }
+inline ShapeOp rotateOp(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) { ShapeOp op = { SHAPE_ROTATE, { angle, x, y, z }, 0 }; return op; }
+inline ShapeOp scaleOp(GLfloat x, GLfloat y, GLfloat z) { ShapeOp op = { SHAPE_SCALE, { x, y, z, 0 }, 0 }; return op; }
+inline ShapeOp visibleOp(bool visible) { ShapeOp op = { SHAPE_VISIBLE, { visible ? 1.0f : 0.0f, 0, 0, 0 }, 0 }; return op; }
+
+const int GLOBAL_SHAPE = -1; // the shape id of operations on the whole object
+const int NO_SHAPE = -2; // the shape id of a name that is not in the object
+
+// everything needed to create an object that does not need opengl, so it can be loaded on any thread
+struct LoadedModel {
+	shared_ptr<MeshData> mesh;
+	vector<DecodedTexture> textures; // the decoded textures of the mesh materials
+};
+
 // this class handle drawing objects given by .obj files
 class ObjectGL {
 	protected:
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes; // the shapes that make the object
-		std::vector<tinyobj::material_t> materials; // the object materials
-		map<string, GLuint> textures; // map texture file name to it's opengl texture id
+		map<string, GLuint> textures; // map texture file name to it's opengl texture id (owned by the texture registry)
+		shared_ptr<MeshData> mesh; // the triangulated shapes and materials of the object
+		GLuint vertexBuffer = 0; // opengl buffer holding vertices (0 if buffer objects are not supported)
+		GLuint indexBuffer = 0; // opengl buffer holding indices (0 if buffer objects are not supported)
+		static bool importObj(const string& inputfile, MeshData& mesh); // parse an .obj file and triangulate its shapes into the mesh
+		void loadTextures(const vector<DecodedTexture>& decoded); // acquire the textures used by the mesh materials
+		static string findTextureFile(const string& objectDir, const string& textureName); // the path of a texture file, searching the object and textures directories
+		void uploadMesh(); // upload vertices and indices to opengl buffers
+		void bindMesh(); // set the vertex arrays for drawing the mesh
+		void unbindMesh(); // restore the vertex arrays state
+		void resolveMaterials(); // store the material colors and texture id on each draw range
+		static void applyMaterial(const MeshMaterial& material); // set the opengl material and texture of a draw range
+		const GLvoid* indexData(GLuint firstIndex); // pointer (or buffer offset) of an index for glDrawElements
+		vector<ShapeOp> shapeOps; // the operations of the whole object and then of every shape, in order
+		vector<size_t> shapeOpOffsets; // the first operation of every slot (0 is the whole object, shape id + 1 the shapes) and the end
+		vector<MeshMaterial> materialOverrides; // the materials of the SHAPE_MATERIAL operations
+		vector<function<void()>> callbacks; // the functions of the SHAPE_CALLBACK operations
+		bool applyShapeOps(size_t slot, int& materialOverride, int& currentMaterial); // apply the operations of a slot, false if it is hidden
+		bool shapeTransform(size_t slot, glm::mat4& matrix, int& materialOverride) const; // the operations of a slot as a matrix (without callbacks), false if it is hidden
+		void appendTriangles(const glm::mat4& placement, vector<glm::vec3>& corners) const; // worldTriangles with a placement between the object and shape operations
+		static const int NO_MATERIAL = -2; // no material was set yet (-1 is the default material)
+		float projectedRadius(const glm::mat4& clip); // the radius in pixels of the object bounding sphere
+		void selectLod(const glm::mat4& clip); // pick the level of detail from the projected size
+		static int nextLodLevel(float radius, int level); // the level of detail for a projected radius, starting from the current level
+		bool batched = false; // drawn by the static batch instead of draw()
+		friend class StaticBatch;
 	public:
 		ObjectGL(string inputfile, GLfloat PosX = 0, GLfloat PosY = 0, GLfloat PosZ = 0, GLfloat scale = 1.0f,
 			     glm::vec3 upVector = glm::vec3(0, 1, 0), glm::vec3 towardVector = glm::vec3(0, 0, 0), GLfloat angle = 0);
 		ObjectGL() = default;
+		ObjectGL(const ObjectGL&) = delete; // the object owns opengl buffers
+		ObjectGL& operator=(const ObjectGL&) = delete;
+		virtual ~ObjectGL();
 		string inputfile; // the .obj file defining the object
 		GLfloat PosX; // the x object position 
 		GLfloat PosZ; // the z object position 
@@ -46,13 +114,29 @@ class ObjectGL {
 		float vibrationFrequency = 0.0f;
 		glm::vec3 towardVector; // where the object "look" (use for movement)
 		glm::vec3 upVector; // the up direction
-		map<string, vector<function<void()>>> shapesTasks; // drawing tasks add to specific shape (or to the whole object)
-		void draw(); // draw the object
+		int lodLevel = 0; // the level of detail drawn (0 is the full detail)
+		GLsizei trianglesDrawn = 0; // the triangles drawn by the last draw call
+		static bool lodEnabled; // draw simplified levels of small objects
+		static bool cullingEnabled; // skip the objects and shapes that are out of the view
+		static CullStats cullStats; // the objects and shapes drawn and culled since the last reset
+		bool isStatic = false; // placed once and rarely moved, so the static batch can bake it into world space
+		static bool staticBatching; // draw the static objects from the static batch
+		glm::mat4 modelMatrix() const; // the position, angle and scale transform
+		GLsizei triangleCount(int level) const; // the triangles of a level of detail
+		virtual void worldTriangles(vector<glm::vec3>& corners) const; // append the full detail triangles of the visible shapes in world space (three corners each)
+		virtual void draw(); // draw the object
 		void vibrate(float amplitude, float frequency, float time, float initialPos);
 		void setVibration(bool enable, float initialPos);
 		void setPosition(GLfloat x, GLfloat y, GLfloat z); // set the position of the object
 		void rotate(GLfloat angle); // rotate the object
-		void addTask(function<void()> func, string shape = "GLOBAL"); // add task shapesTasks
+		int findShape(const string& name) const; // the id of a shape ("GLOBAL" for the whole object), resolve it once and keep it
+		int addOp(const ShapeOp& op, int shape = GLOBAL_SHAPE); // add an operation to a shape, returns its index in the shape
+		ShapeOp* shapeOp(int shape, int index); // an operation to change (for animations), NULL if there is none, valid until the next addOp
+		int addMaterialOverride(const MeshMaterial& material, int shape = GLOBAL_SHAPE); // draw a shape with another material
+		void addTask(function<void()> func, string shape = "GLOBAL"); // add a callback operation (for what the typed operations can not do)
 		void walk(GLfloat distance); // move the object foreward
-		static GLuint create_texture(string texture_filename); // create opengl texture and return it's id
+		static GLuint create_texture(string texture_filename); // acquire an opengl texture from the texture registry and return it's id
+		static shared_ptr<MeshData> loadMesh(const string& inputfile); // load an .obj file from its mesh cache, or import it and write the cache (null if the import failed)
+		static shared_ptr<LoadedModel> loadModel(const string& inputfile); // load the mesh and decode the textures of an .obj file (thread safe), its mesh is null if it failed
+		static string resolvePath(const string& inputfile); // the path of an .obj file, searching the objects directory
 };
\ No newline at end of file
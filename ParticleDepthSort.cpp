@@ -0,0 +1,113 @@
+#include "ParticleDepthSort.h"
+#include "FrameProfiler.h"
+#include <algorithm>
+
+// the depth along the view direction of a particle at the position it is drawn
+static inline float drawnDepth(const ParticleSystem& particles, size_t i, const glm::vec3& eye, const glm::vec3& forward, float lag) {
+    return (particles.posX[i] - particles.velX[i] * lag - eye.x) * forward.x + (particles.posY[i] - particles.velY[i] * lag - eye.y) * forward.y +
+        (particles.posZ[i] - particles.velZ[i] * lag - eye.z) * forward.z;
+}
+
+const vector<uint32_t>& ParticleDepthSort::sort(const ParticleSystem& particles, const glm::vec3& eye, const glm::vec3& forward, float lag) {
+    ProfileScope scope("bubbles sort");
+    double start = FrameProfiler::now();
+    size_t count = particles.count();
+
+    // start from the last order: the particles that died were replaced by the last ones (swap and pop),
+    // so the slots still in use keep their place and the new slots go to the end
+    size_t previous = this->indices.size();
+    size_t kept = 0;
+    for (size_t k = 0; k < previous; k++) {
+        if (this->indices[k] < count) {
+            this->indices[kept++] = this->indices[k];
+        }
+    }
+    this->indices.resize(count);
+    for (size_t i = previous; i < count; i++) {
+        this->indices[kept++] = (uint32_t)i;
+    }
+
+    // the depth of every particle along the view direction, quantized over the range of the frame
+    float nearest = 0, farthest = 0;
+    for (size_t i = 0; i < count; i++) {
+        float depth = drawnDepth(particles, i, eye, forward, lag);
+        nearest = i == 0 ? depth : min(nearest, depth);
+        farthest = i == 0 ? depth : max(farthest, depth);
+    }
+    float scale = farthest > nearest ? 65535.0f / (farthest - nearest) : 0.0f;
+    this->keys.resize(count);
+    this->stats.outOfOrder = 0;
+    for (size_t k = 0; k < count; k++) {
+        uint32_t i = this->indices[k];
+        float depth = drawnDepth(particles, i, eye, forward, lag);
+        this->keys[k] = (uint16_t)((farthest - depth) * scale); // the farthest particle has key 0
+        if (k > 0 && this->keys[k] < this->keys[k - 1]) {
+            this->stats.outOfOrder++;
+        }
+    }
+
+    this->stats.radixPasses = 0;
+    if (this->stats.outOfOrder == 0) {
+        this->stats.path = DEPTH_SORT_KEPT;
+    }
+    else if (this->stats.outOfOrder * DEPTH_INSERTION_RATIO <= count) {
+        this->stats.path = DEPTH_SORT_INSERTION;
+        insertionSort();
+    }
+    else {
+        this->stats.path = DEPTH_SORT_RADIX;
+        radixSort();
+    }
+    this->stats.ms = FrameProfiler::now() - start;
+    return this->indices;
+}
+
+void ParticleDepthSort::insertionSort() {
+    for (size_t k = 1; k < this->keys.size(); k++) {
+        uint16_t key = this->keys[k];
+        uint32_t index = this->indices[k];
+        size_t j = k;
+        for (; j > 0 && this->keys[j - 1] > key; j--) {
+            this->keys[j] = this->keys[j - 1];
+            this->indices[j] = this->indices[j - 1];
+        }
+        this->keys[j] = key;
+        this->indices[j] = index;
+    }
+}
+
+void ParticleDepthSort::radixSort() {
+    size_t count = this->keys.size();
+    this->scratchKeys.resize(count);
+    this->scratchIndices.resize(count);
+
+    // the histograms of both bytes in one pass
+    size_t histograms[2][256] = {};
+    for (uint16_t key : this->keys) {
+        histograms[0][key & 0xFF]++;
+        histograms[1][key >> 8]++;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        size_t* histogram = histograms[pass];
+        int shift = pass * 8;
+        if (histogram[(this->keys[0] >> shift) & 0xFF] == count) {
+            continue; // every key has the same byte, the pass would not move anything
+        }
+        size_t offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        // stable scatter, so the pass keeps the order of the previous one within a digit
+        for (size_t k = 0; k < count; k++) {
+            size_t destination = histogram[(this->keys[k] >> shift) & 0xFF]++;
+            this->scratchKeys[destination] = this->keys[k];
+            this->scratchIndices[destination] = this->indices[k];
+        }
+        this->keys.swap(this->scratchKeys);
+        this->indices.swap(this->scratchIndices);
+        this->stats.radixPasses++;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "ParticleSystem.h"
+
+using namespace std;
+
+// how the last sort was done
+enum DepthSortPath {
+    DEPTH_SORT_KEPT, // the order of the last frame was still sorted
+    DEPTH_SORT_INSERTION, // few particles were out of order, fixed by an insertion sort
+    DEPTH_SORT_RADIX // a radix sort of the keys
+};
+
+// the cost of the last sort
+struct DepthSortStats {
+    DepthSortPath path = DEPTH_SORT_KEPT;
+    size_t outOfOrder = 0; // neighbours out of order in the order of the last frame
+    int radixPasses = 0; // the byte passes done (a pass where every key has the same byte is skipped)
+    double ms = 0;
+};
+
+const size_t DEPTH_INSERTION_RATIO = 64; // sort by insertion when at most one particle in this many is out of order
+
+// Orders the particles from the farthest to the nearest along the view direction, for blending.
+// The depths are quantized to 16 bit keys over the depth range of the frame. The order of the last
+// frame is the starting point: the particles move little between frames, so it is often still sorted
+// or nearly so, which an insertion sort fixes in linear time; otherwise a two pass radix sort (one per
+// key byte) runs, skipping the high byte when all the particles share it.
+class ParticleDepthSort {
+public:
+    // sort the live particles, returns their indices from back to front; lag moves them back along their
+    // velocity to where they are drawn (see BubbleRenderer::position)
+    const vector<uint32_t>& sort(const ParticleSystem& particles, const glm::vec3& eye, const glm::vec3& forward, float lag = 0.0f);
+    const vector<uint32_t>& order() const { return this->indices; }
+    DepthSortStats stats;
+
+private:
+    vector<uint32_t> indices; // the particles in the order of the last sort
+    vector<uint16_t> keys; // the keys of the particles, in the order of the indices
+    vector<uint32_t> scratchIndices;
+    vector<uint16_t> scratchKeys;
+
+    void insertionSort();
+    void radixSort();
+};
@@ -0,0 +1,53 @@
+#include "ParticleGrid.h"
+#include <algorithm>
+#include <cmath>
+
+void ParticleGrid::build(const float* x, const float* y, const float* z, size_t count, const ParticleBounds& bounds, float cellSize) {
+    posX = x;
+    posY = y;
+    posZ = z;
+
+    // no more cells than a few per particle, and no more than the limit on a side, however small the particles
+    float extents[3];
+    for (int axis = 0; axis < 3; axis++) {
+        extents[axis] = std::max(bounds.upper[axis] - bounds.lower[axis], 1e-6f);
+    }
+    float volume = extents[0] * extents[1] * extents[2];
+    cellSize = std::max(cellSize, std::cbrt(volume / (PARTICLE_GRID_CELLS_PER_PARTICLE * std::max(count, (size_t)1))));
+    float inverse[3];
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = extents[axis];
+        float side = std::max(cellSize, extent / PARTICLE_GRID_MAX_CELLS);
+        cells[axis] = std::max((int)std::ceil(extent / side), 1);
+        inverse[axis] = cells[axis] / extent;
+    }
+
+    // count the particles of every cell
+    cellStart.assign(cellCount() + 1, 0);
+    cellOf.resize(count);
+    const float* positions[3] = { x, y, z };
+    for (size_t i = 0; i < count; i++) {
+        int c[3];
+        for (int axis = 0; axis < 3; axis++) {
+            int cell = (int)((positions[axis][i] - bounds.lower[axis]) * inverse[axis]);
+            c[axis] = std::min(std::max(cell, 0), cells[axis] - 1);
+        }
+        uint32_t cell = (uint32_t)cellIndex(c[0], c[1], c[2]);
+        cellOf[i] = cell;
+        cellStart[cell + 1]++;
+    }
+
+    // where every cell starts, then the particles in cell order
+    for (size_t cell = 0; cell < cellCount(); cell++) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+    sorted.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        sorted[cellStart[cellOf[i]]++] = (uint32_t)i;
+    }
+    // the writes moved every start to the end of its cell, which is the start of the next one
+    for (size_t cell = cellCount(); cell > 0; cell--) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+    cellStart[0] = 0;
+}
@@ -0,0 +1,115 @@
+#ifndef PARTICLEGRID_H
+#define PARTICLEGRID_H
+
+#include "ParticleKernels.h"
+#include <cstdint>
+#include <vector>
+
+const int PARTICLE_GRID_MAX_CELLS = 128; ///< The most cells along one side of the grid.
+const float PARTICLE_GRID_CELLS_PER_PARTICLE = 8.0f; ///< The most cells per particle, larger cells when there are few particles.
+
+/**
+ * @brief A uniform grid over the box of a particle system, to find the particles close to each other.
+ *
+ * The grid is rebuilt from scratch with a counting sort: one pass counts the particles of every cell,
+ * a prefix sum gives where each cell starts and a last pass writes the particles cell after cell, so a
+ * build is linear in the particles and the cells and does not allocate once the arrays have grown.
+ * The particles of a cell are contiguous, in their order in the system, so the queries are
+ * deterministic. Particles outside the box are put in the nearest cell. The cells are made larger
+ * than asked when there are few particles, so that visiting the empty cells does not cost more
+ * than testing the pairs.
+ */
+class ParticleGrid {
+public:
+    /**
+     * @brief Sort the particles into cells.
+     *
+     * @param x, y, z The positions of the particles.
+     * @param count The number of particles.
+     * @param bounds The box covered by the grid.
+     * @param cellSize The smallest side of a cell, at least the largest distance that will be queried.
+     */
+    void build(const float* x, const float* y, const float* z, size_t count, const ParticleBounds& bounds, float cellSize);
+
+    /**
+     * @brief Visit every pair of particles closer than their contact distance, each pair once.
+     *
+     * Every cell is paired with itself and with half of its 26 neighbours (the ones after it), so the
+     * other half is covered from the other side. The contact distance of a pair is given by
+     * reach(i) + reach(j) and must not exceed the cell size.
+     *
+     * @param reach Returns how far a particle touches (its radius), or a negative value to skip it.
+     * @param visit Called with the two particles (the first one has the lower index) and their squared distance.
+     */
+    template <typename Reach, typename Visit>
+    void forEachPair(Reach reach, Visit visit) const {
+        static const int forward[13][3] = {
+            { 1, 0, 0 }, { -1, 1, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+            { -1, -1, 1 }, { 0, -1, 1 }, { 1, -1, 1 }, { -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 }, { -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 }
+        };
+        for (int cz = 0; cz < cells[2]; cz++) {
+            for (int cy = 0; cy < cells[1]; cy++) {
+                for (int cx = 0; cx < cells[0]; cx++) {
+                    size_t cell = cellIndex(cx, cy, cz);
+                    uint32_t begin = cellStart[cell], end = cellStart[cell + 1];
+                    if (begin == end) {
+                        continue;
+                    }
+                    for (uint32_t a = begin; a < end; a++) {
+                        for (uint32_t b = a + 1; b < end; b++) {
+                            test(sorted[a], sorted[b], reach, visit);
+                        }
+                    }
+                    for (const int* offset : forward) {
+                        int nx = cx + offset[0], ny = cy + offset[1], nz = cz + offset[2];
+                        if (nx < 0 || ny < 0 || nz < 0 || nx >= cells[0] || ny >= cells[1] || nz >= cells[2]) {
+                            continue;
+                        }
+                        size_t neighbour = cellIndex(nx, ny, nz);
+                        for (uint32_t a = begin; a < end; a++) {
+                            for (uint32_t b = cellStart[neighbour]; b < cellStart[neighbour + 1]; b++) {
+                                test(sorted[a], sorted[b], reach, visit);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief The number of cells of the grid.
+     */
+    size_t cellCount() const {
+        return (size_t)cells[0] * cells[1] * cells[2];
+    }
+
+private:
+    const float* posX = NULL; ///< The positions of the last build
+    const float* posY = NULL;
+    const float* posZ = NULL;
+    int cells[3] = { 0, 0, 0 }; ///< The number of cells along x, y and z
+    std::vector<uint32_t> cellOf; ///< The cell of every particle
+    std::vector<uint32_t> cellStart; ///< Where the particles of every cell start in sorted (one more entry for the end)
+    std::vector<uint32_t> sorted; ///< The particles, cell after cell
+
+    size_t cellIndex(int x, int y, int z) const {
+        return ((size_t)z * cells[1] + y) * cells[0] + x;
+    }
+
+    template <typename Reach, typename Visit>
+    void test(uint32_t i, uint32_t j, Reach& reach, Visit& visit) const {
+        float reachI = reach(i), reachJ = reach(j);
+        if (reachI < 0.0f || reachJ < 0.0f) {
+            return;
+        }
+        float dx = posX[i] - posX[j], dy = posY[i] - posY[j], dz = posZ[i] - posZ[j];
+        float distance2 = dx * dx + dy * dy + dz * dz;
+        float contact = reachI + reachJ;
+        if (distance2 < contact * contact) {
+            i < j ? visit(i, j, distance2) : visit(j, i, distance2);
+        }
+    }
+};
+
+#endif // PARTICLEGRID_H
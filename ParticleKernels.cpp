@@ -0,0 +1,247 @@
+#include "ParticleKernels.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PARTICLE_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PARTICLE_AVX2_TARGET
+#else
+#define PARTICLE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// the reference kernel, also used for the particles left over by the vector kernels
+static void updateScalar(const ParticleStreams& p, size_t i, size_t end, const ParticleBounds& b, float deltaTime) {
+    const float fall = PARTICLE_GRAVITY * deltaTime;
+    for (; i < end; i++) {
+        float velY = p.velY[i] - fall;
+        float x = p.posX[i] + p.velX[i] * deltaTime;
+        float y = p.posY[i] + velY * deltaTime;
+        float z = p.posZ[i] + p.velZ[i] * deltaTime;
+        float size = p.size[i];
+        bool out = (x - size < b.lower[0]) | (x + size > b.upper[0]) |
+            (y - size < b.lower[1]) | (y + size > b.upper[1]) |
+            (z - size < b.lower[2]) | (z + size > b.upper[2]);
+        p.velY[i] = velY;
+        p.posX[i] = x;
+        p.posY[i] = y;
+        p.posZ[i] = z;
+        p.life[i] = out ? 0.0f : p.life[i] - deltaTime;
+    }
+}
+
+#ifdef PARTICLE_SIMD
+static void updateSse(const ParticleStreams& p, size_t i, size_t end, const ParticleBounds& b, float deltaTime) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 fall = _mm_set1_ps(PARTICLE_GRAVITY * deltaTime);
+    const __m128 lowerX = _mm_set1_ps(b.lower[0]), upperX = _mm_set1_ps(b.upper[0]);
+    const __m128 lowerY = _mm_set1_ps(b.lower[1]), upperY = _mm_set1_ps(b.upper[1]);
+    const __m128 lowerZ = _mm_set1_ps(b.lower[2]), upperZ = _mm_set1_ps(b.upper[2]);
+    for (; i + 4 <= end; i += 4) {
+        __m128 velY = _mm_sub_ps(_mm_loadu_ps(p.velY + i), fall);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(p.posX + i), _mm_mul_ps(_mm_loadu_ps(p.velX + i), dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(p.posY + i), _mm_mul_ps(velY, dt));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(p.posZ + i), _mm_mul_ps(_mm_loadu_ps(p.velZ + i), dt));
+        __m128 size = _mm_loadu_ps(p.size + i);
+
+        // all six sides in one mask, no branches
+        __m128 out = _mm_or_ps(_mm_cmplt_ps(_mm_sub_ps(x, size), lowerX), _mm_cmpgt_ps(_mm_add_ps(x, size), upperX));
+        out = _mm_or_ps(out, _mm_or_ps(_mm_cmplt_ps(_mm_sub_ps(y, size), lowerY), _mm_cmpgt_ps(_mm_add_ps(y, size), upperY)));
+        out = _mm_or_ps(out, _mm_or_ps(_mm_cmplt_ps(_mm_sub_ps(z, size), lowerZ), _mm_cmpgt_ps(_mm_add_ps(z, size), upperZ)));
+        __m128 life = _mm_andnot_ps(out, _mm_sub_ps(_mm_loadu_ps(p.life + i), dt));
+
+        _mm_storeu_ps(p.velY + i, velY);
+        _mm_storeu_ps(p.posX + i, x);
+        _mm_storeu_ps(p.posY + i, y);
+        _mm_storeu_ps(p.posZ + i, z);
+        _mm_storeu_ps(p.life + i, life);
+    }
+    updateScalar(p, i, end, b, deltaTime);
+}
+
+PARTICLE_AVX2_TARGET
+static void updateAvx2(const ParticleStreams& p, size_t i, size_t end, const ParticleBounds& b, float deltaTime) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 fall = _mm256_set1_ps(PARTICLE_GRAVITY * deltaTime);
+    const __m256 lowerX = _mm256_set1_ps(b.lower[0]), upperX = _mm256_set1_ps(b.upper[0]);
+    const __m256 lowerY = _mm256_set1_ps(b.lower[1]), upperY = _mm256_set1_ps(b.upper[1]);
+    const __m256 lowerZ = _mm256_set1_ps(b.lower[2]), upperZ = _mm256_set1_ps(b.upper[2]);
+    for (; i + 8 <= end; i += 8) {
+        __m256 velY = _mm256_sub_ps(_mm256_loadu_ps(p.velY + i), fall);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(p.posX + i), _mm256_mul_ps(_mm256_loadu_ps(p.velX + i), dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(p.posY + i), _mm256_mul_ps(velY, dt));
+        __m256 z = _mm256_add_ps(_mm256_loadu_ps(p.posZ + i), _mm256_mul_ps(_mm256_loadu_ps(p.velZ + i), dt));
+        __m256 size = _mm256_loadu_ps(p.size + i);
+
+        __m256 out = _mm256_or_ps(_mm256_cmp_ps(_mm256_sub_ps(x, size), lowerX, _CMP_LT_OQ),
+            _mm256_cmp_ps(_mm256_add_ps(x, size), upperX, _CMP_GT_OQ));
+        out = _mm256_or_ps(out, _mm256_or_ps(_mm256_cmp_ps(_mm256_sub_ps(y, size), lowerY, _CMP_LT_OQ),
+            _mm256_cmp_ps(_mm256_add_ps(y, size), upperY, _CMP_GT_OQ)));
+        out = _mm256_or_ps(out, _mm256_or_ps(_mm256_cmp_ps(_mm256_sub_ps(z, size), lowerZ, _CMP_LT_OQ),
+            _mm256_cmp_ps(_mm256_add_ps(z, size), upperZ, _CMP_GT_OQ)));
+        __m256 life = _mm256_andnot_ps(out, _mm256_sub_ps(_mm256_loadu_ps(p.life + i), dt));
+
+        _mm256_storeu_ps(p.velY + i, velY);
+        _mm256_storeu_ps(p.posX + i, x);
+        _mm256_storeu_ps(p.posY + i, y);
+        _mm256_storeu_ps(p.posZ + i, z);
+        _mm256_storeu_ps(p.life + i, life);
+    }
+    updateScalar(p, i, end, b, deltaTime);
+}
+
+static bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+ParticleKernel bestParticleKernel() {
+#ifdef PARTICLE_SIMD
+    static const ParticleKernel best = cpuHasAvx2() ? PARTICLE_KERNEL_AVX2 : PARTICLE_KERNEL_SSE;
+    return best;
+#else
+    return PARTICLE_KERNEL_SCALAR;
+#endif
+}
+
+const char* particleKernelName(ParticleKernel kernel) {
+    switch (kernel) {
+    case PARTICLE_KERNEL_SSE:
+        return "SSE";
+    case PARTICLE_KERNEL_AVX2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+void updateParticles(const ParticleStreams& streams, size_t begin, size_t end, const ParticleBounds& bounds,
+    float deltaTime, ParticleKernel kernel) {
+#ifdef PARTICLE_SIMD
+    if (kernel == PARTICLE_KERNEL_AVX2) {
+        updateAvx2(streams, begin, end, bounds, deltaTime);
+        return;
+    }
+    if (kernel == PARTICLE_KERNEL_SSE) {
+        updateSse(streams, begin, end, bounds, deltaTime);
+        return;
+    }
+#endif
+    updateScalar(streams, begin, end, bounds, deltaTime);
+}
+
+void collideParticles(const ParticleStreams& p, size_t begin, size_t end, const ParticleField& field) {
+    if (field.distance == NULL || field.response == PARTICLE_COLLIDE_OFF) {
+        return;
+    }
+    const float inverse = 1.0f / field.cellSize;
+    const int rowX = 1, rowY = field.cells[0], rowZ = field.cells[0] * field.cells[1];
+    for (size_t i = begin; i < end; i++) {
+        if (p.life[i] <= 0.0f) {
+            continue;
+        }
+        // the cell centers around the particle and its place between them
+        float position[3] = { p.posX[i], p.posY[i], p.posZ[i] };
+        int base[3];
+        float t[3];
+        for (int axis = 0; axis < 3; axis++) {
+            float g = (position[axis] - field.lower[axis]) * inverse - 0.5f;
+            g = min(max(g, 0.0f), (float)(field.cells[axis] - 1));
+            base[axis] = min((int)g, field.cells[axis] - 2);
+            t[axis] = g - base[axis];
+        }
+        const float* c = field.distance + base[0] * rowX + base[1] * rowY + base[2] * rowZ;
+        float c000 = c[0], c100 = c[rowX], c010 = c[rowY], c110 = c[rowX + rowY];
+        float c001 = c[rowZ], c101 = c[rowX + rowZ], c011 = c[rowY + rowZ], c111 = c[rowX + rowY + rowZ];
+
+        // trilinear distance
+        float x00 = c000 + (c100 - c000) * t[0], x10 = c010 + (c110 - c010) * t[0];
+        float x01 = c001 + (c101 - c001) * t[0], x11 = c011 + (c111 - c011) * t[0];
+        float y0 = x00 + (x10 - x00) * t[1], y1 = x01 + (x11 - x01) * t[1];
+        float distance = y0 + (y1 - y0) * t[2];
+        float radius = p.size[i] * 0.5f;
+        if (distance >= radius) {
+            continue;
+        }
+        if (field.response == PARTICLE_COLLIDE_POP) {
+            p.life[i] = 0.0f;
+            continue;
+        }
+
+        // the gradient of the trilinear distance points away from the geometry
+        float dx0 = (c100 - c000) + ((c110 - c010) - (c100 - c000)) * t[1];
+        float dx1 = (c101 - c001) + ((c111 - c011) - (c101 - c001)) * t[1];
+        float gradX = dx0 + (dx1 - dx0) * t[2];
+        float gradY = (x10 - x00) + ((x11 - x01) - (x10 - x00)) * t[2];
+        float gradZ = y1 - y0;
+        float length = sqrtf(gradX * gradX + gradY * gradY + gradZ * gradZ);
+        if (length < 1e-6f) {
+            gradX = gradZ = 0.0f; // flat field (deep inside or far away), push up
+            gradY = length = 1.0f;
+        }
+        float nx = gradX / length, ny = gradY / length, nz = gradZ / length;
+
+        // out of the geometry, then reflect the speed toward it
+        float push = radius - distance;
+        p.posX[i] += nx * push;
+        p.posY[i] += ny * push;
+        p.posZ[i] += nz * push;
+        float toward = p.velX[i] * nx + p.velY[i] * ny + p.velZ[i] * nz;
+        if (toward < 0.0f) {
+            float change = (1.0f + field.restitution) * toward;
+            p.velX[i] -= change * nx;
+            p.velY[i] -= change * ny;
+            p.velZ[i] -= change * nz;
+        }
+    }
+}
+
+void updateParticlesParallel(const ParticleStreams& streams, size_t count, const ParticleBounds& bounds,
+    float deltaTime, ParticleKernel kernel, ThreadPool* pool, const ParticleField* field) {
+    size_t chunks = (count + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE;
+    if (pool == NULL || pool->size() == 0 || chunks < 2) {
+        updateParticles(streams, 0, count, bounds, deltaTime, kernel);
+        if (field != NULL) {
+            collideParticles(streams, 0, count, *field);
+        }
+        return;
+    }
+
+    // the chunks only depend on the particle count, the threads take the next one until none is left
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+            size_t begin = chunk * PARTICLE_CHUNK_SIZE, end = min(begin + PARTICLE_CHUNK_SIZE, count);
+            updateParticles(streams, begin, end, bounds, deltaTime, kernel);
+            if (field != NULL) {
+                collideParticles(streams, begin, end, *field);
+            }
+        }
+    };
+    vector<future<void>> helpers;
+    size_t helperCount = min((size_t)pool->size(), chunks - 1);
+    for (size_t i = 0; i < helperCount; i++) {
+        helpers.push_back(pool->submit(work));
+    }
+    work();
+    for (future<void>& helper : helpers) {
+        helper.wait();
+    }
+}
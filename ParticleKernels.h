@@ -0,0 +1,123 @@
+#ifndef PARTICLEKERNELS_H
+#define PARTICLEKERNELS_H
+
+#include <cstddef>
+
+class ThreadPool;
+
+/**
+ * @brief The box the particles live in; a particle touching one of its sides dies.
+ */
+struct ParticleBounds {
+    float lower[3]; ///< The minimum x, y and z a particle may reach (minus its size).
+    float upper[3]; ///< The maximum x, y and z a particle may reach (plus its size).
+};
+
+/**
+ * @brief The streams read and written by the particle update, each one holding a float per particle.
+ */
+struct ParticleStreams {
+    float* posX;
+    float* posY;
+    float* posZ;
+    float* velX;
+    float* velY;
+    float* velZ;
+    float* life;
+    const float* size;
+};
+
+/**
+ * @brief What a particle does when it touches the scene geometry of a distance field.
+ */
+enum ParticleCollision {
+    PARTICLE_COLLIDE_OFF, ///< Nothing, the particles go through the scene.
+    PARTICLE_COLLIDE_POP, ///< The particle dies.
+    PARTICLE_COLLIDE_BOUNCE ///< The particle is pushed out of the geometry and its velocity reflected.
+};
+
+/**
+ * @brief A signed distance field of the scene sampled by the particle update, and what the particles do on it.
+ *
+ * The distances are stored at the centers of cells[0] * cells[1] * cells[2] cells (at least two along
+ * every axis), x varying fastest, negative inside the geometry. Positions outside the grid take the distance of the nearest border.
+ */
+struct ParticleField {
+    const float* distance; ///< The distances at the cell centers (NULL for no field).
+    int cells[3]; ///< The number of cells along x, y and z.
+    float lower[3]; ///< The corner of the first cell.
+    float cellSize; ///< The side of a cell.
+    ParticleCollision response; ///< What a particle touching the geometry does.
+    float restitution; ///< The part of the speed toward the geometry kept by a bounce.
+};
+
+const float PARTICLE_GRAVITY = 1.0f; ///< Downward acceleration of the bubbles (reduced for slower falling).
+const size_t PARTICLE_CHUNK_SIZE = 16384; ///< Particles per job of the parallel update (a multiple of the vector width).
+
+/**
+ * @brief The instruction sets the particle update is written for.
+ *
+ * Every kernel does the same operations in the same order without fused multiply-add, so they all
+ * produce the same particles.
+ */
+enum ParticleKernel {
+    PARTICLE_KERNEL_SCALAR, ///< One particle at a time, runs everywhere.
+    PARTICLE_KERNEL_SSE, ///< Four particles at a time (SSE2).
+    PARTICLE_KERNEL_AVX2 ///< Eight particles at a time (AVX2, chosen at runtime).
+};
+
+/**
+ * @brief The widest kernel the processor supports.
+ */
+ParticleKernel bestParticleKernel();
+
+/**
+ * @brief The name of a kernel, for the debug window and the benchmark.
+ */
+const char* particleKernelName(ParticleKernel kernel);
+
+/**
+ * @brief Update the particles [begin, end) of the streams.
+ *
+ * Applies gravity to the velocity, moves the particle, decreases its life by the elapsed time and
+ * sets the life of the particles that touched the bounds to 0.
+ *
+ * @param streams The particle streams.
+ * @param begin The first particle to update.
+ * @param end One past the last particle to update.
+ * @param bounds The box the particles live in.
+ * @param deltaTime The time elapsed since the last update, in seconds.
+ * @param kernel The instruction set to use (must be supported by the processor).
+ */
+void updateParticles(const ParticleStreams& streams, size_t begin, size_t end, const ParticleBounds& bounds,
+    float deltaTime, ParticleKernel kernel);
+
+/**
+ * @brief Collide the particles [begin, end) of the streams with the scene geometry of a distance field.
+ *
+ * Every live particle samples the field at its center with a trilinear lookup (eight cells), so the
+ * cost does not depend on the number of triangles in the scene. A particle touches the geometry when
+ * the distance is under its radius (half its size); the normal is the gradient of the trilinear lookup.
+ *
+ * @param streams The particle streams.
+ * @param begin The first particle to collide.
+ * @param end One past the last particle to collide.
+ * @param field The distance field and the response.
+ */
+void collideParticles(const ParticleStreams& streams, size_t begin, size_t end, const ParticleField& field);
+
+/**
+ * @brief Update the particles [0, count) of the streams on several threads.
+ *
+ * The particles are split in chunks of PARTICLE_CHUNK_SIZE that the pool workers and the calling thread
+ * take in turn. Every particle is updated on its own by the same kernel, so the result does not depend on
+ * the number of threads or on which thread updated which chunk. Returns when every chunk is done.
+ * A chunk is collided with the field right after its update, while it is still in the cache.
+ *
+ * @param pool The workers to share the update with (NULL updates on the calling thread only).
+ * @param field The scene to collide the particles with (NULL for none).
+ */
+void updateParticlesParallel(const ParticleStreams& streams, size_t count, const ParticleBounds& bounds,
+    float deltaTime, ParticleKernel kernel, ThreadPool* pool, const ParticleField* field = NULL);
+
+#endif // PARTICLEKERNELS_H
@@ -2,83 +2,299 @@
 #define PARTICLESYSTEM_H
 
 #include "Particle.h"
+#include "Emitter.h"
+#include "ParticleKernels.h"
+#include "ParticleGrid.h"
 #include <vector>
 #include <algorithm>
 #include <cstdlib>
-#include <GL/glu.h> // Include GLU for drawing spheres
+#include <cmath>
+
+/**
+ * @brief What a full particle system does with a new particle.
+ */
+enum ParticleOverflow {
+    PARTICLE_DROP_OLDEST, ///< Remove the oldest live particle to make room.
+    PARTICLE_REFUSE_SPAWN ///< Do not add the new particle.
+};
+
+/**
+ * @brief What two particles do when they touch.
+ */
+enum ParticleContact {
+    PARTICLE_PASS_THROUGH, ///< Nothing, the particles ignore each other.
+    PARTICLE_MERGE, ///< The larger particle absorbs the smaller one (both pop when too large).
+    PARTICLE_POP ///< Both particles die.
+};
+
+const size_t PARTICLE_DEFAULT_CAPACITY = 4096; ///< Particles a system holds unless told otherwise.
+const int PARTICLE_NONE = -1; ///< No particle (the ends of the age list).
 
 /**
  * @brief A class representing a particle system.
  *
- * This class manages a collection of particles, allowing them to be updated and drawn.
- * Each particle is represented by an instance of the Particle class.
+ * This class manages a collection of particles, allowing them to be updated (BubbleRenderer draws them).
+ * The particles are stored as a structure of arrays: one stream per property, so the update
+ * reads and writes contiguous floats and processes several particles per instruction.
+ * The box the particles live in is shared by the whole system.
+ *
+ * The streams are allocated once for a fixed capacity and the live particles are kept packed at
+ * their front: a dead particle is replaced by the last live one (swap and pop), so spawning and
+ * killing never allocate. The particles are also linked from the oldest to the youngest, so the
+ * oldest one can be dropped in constant time when the system is full.
+ *
+ * The system owns its emitters and spawns their particles at the start of every update, at the
+ * rate the budget allows.
  */
 class ParticleSystem {
 public:
-    std::vector<Particle> particles; ///< List of particles in the system
+    std::vector<float> posX, posY, posZ; ///< Particle positions
+    std::vector<float> velX, velY, velZ; ///< Particle velocities
+    std::vector<float> life; ///< Remaining life of every particle
+    std::vector<float> size; ///< Particle sizes
+    std::vector<glm::vec4> color; ///< Particle colors (only read when drawing)
+    std::vector<float> spawnLife; ///< The life of every particle when it was spawned (its age is spawnLife - life)
+    ParticleBounds bounds = { { -12.0f, 0.0f, -12.0f }, { 12.0f, 12.0f, 12.0f } }; ///< The box the particles live in
+    ParticleKernel kernel = bestParticleKernel(); ///< The instruction set of the update
+    ThreadPool* pool = NULL; ///< Workers sharing the update (NULL updates on the calling thread)
+    ParticleField field = {}; ///< The scene the particles collide with (no distances for none)
+    ParticleOverflow overflow = PARTICLE_DROP_OLDEST; ///< What a full system does with a new particle
+    size_t peak = 0; ///< The most particles alive at once
+    size_t dropped = 0; ///< Particles removed early to make room
+    size_t refused = 0; ///< Particles not spawned because the system was full
+    ParticleContact contact = PARTICLE_MERGE; ///< What touching particles do
+    float maxMergedSize = 0.6f; ///< The largest particle a merge makes, larger ones pop
+    float contactDelay = 1.0f; ///< Seconds a new particle ignores the others, so a stream leaving an emitter does not merge at once
+    size_t merged = 0; ///< Particles absorbed by merges
+    size_t popped = 0; ///< Particles popped by contacts
+    std::vector<Emitter> emitters; ///< The sources of the particles
+    ParticleBudget budget; ///< Scales the spawn rate of the emitters to the frame time
+
+    /**
+     * @brief Constructor allocating the streams.
+     *
+     * @param capacity The most particles alive at once.
+     */
+    explicit ParticleSystem(size_t capacity = PARTICLE_DEFAULT_CAPACITY) {
+        setCapacity(capacity);
+    }
+
+    /**
+     * @brief Reallocate the streams for another capacity, removing every particle.
+     *
+     * @param capacity The most particles alive at once.
+     */
+    void setCapacity(size_t capacity) {
+        posX.assign(capacity, 0.0f); posY.assign(capacity, 0.0f); posZ.assign(capacity, 0.0f);
+        velX.assign(capacity, 0.0f); velY.assign(capacity, 0.0f); velZ.assign(capacity, 0.0f);
+        life.assign(capacity, 0.0f);
+        size.assign(capacity, 0.0f);
+        color.assign(capacity, glm::vec4(0.0f));
+        spawnLife.assign(capacity, 0.0f);
+        older.assign(capacity, PARTICLE_NONE);
+        younger.assign(capacity, PARTICLE_NONE);
+        live = 0;
+        oldest = youngest = PARTICLE_NONE;
+    }
+
+    /**
+     * @brief Set the box the particles live in; a particle touching a side dies.
+     *
+     * @param lower The minimum x, y and z.
+     * @param upper The maximum x, y and z.
+     */
+    void setBounds(const glm::vec3& lower, const glm::vec3& upper) {
+        ParticleBounds box = { { lower.x, lower.y, lower.z }, { upper.x, upper.y, upper.z } };
+        bounds = box;
+    }
+
+    /**
+     * @brief The number of live particles.
+     */
+    size_t count() const {
+        return live;
+    }
+
+    /**
+     * @brief The most particles alive at once.
+     */
+    size_t capacity() const {
+        return life.size();
+    }
+
+    /**
+     * @brief Add an emitter to the system.
+     *
+     * @param emitter The emitter, copied into the system.
+     * @return The emitter owned by the system (valid until the next emitter is added).
+     */
+    Emitter& addEmitter(const Emitter& emitter) {
+        emitters.push_back(emitter);
+        return emitters.back();
+    }
 
     /**
      * @brief Add a particle to the system.
      *
+     * When the system is full the overflow policy either drops the oldest particle or refuses the new one.
+     *
      * @param particle The particle to be added.
+     * @return True if the particle was added.
      */
-    void addParticle(const Particle& particle) {
-        particles.push_back(particle);
+    bool addParticle(const Particle& particle) {
+        if (live == capacity()) {
+            if (overflow == PARTICLE_REFUSE_SPAWN || oldest == PARTICLE_NONE) {
+                refused++;
+                return false;
+            }
+            kill(oldest);
+            dropped++;
+        }
+        size_t i = live++;
+        posX[i] = particle.position.x;
+        posY[i] = particle.position.y;
+        posZ[i] = particle.position.z;
+        velX[i] = particle.velocity.x;
+        velY[i] = particle.velocity.y;
+        velZ[i] = particle.velocity.z;
+        life[i] = particle.life;
+        spawnLife[i] = particle.life;
+        size[i] = particle.size;
+        color[i] = particle.color;
+
+        // the new particle is the youngest
+        older[i] = youngest;
+        younger[i] = PARTICLE_NONE;
+        if (youngest != PARTICLE_NONE) {
+            younger[youngest] = (int)i;
+        }
+        else {
+            oldest = (int)i;
+        }
+        youngest = (int)i;
+        peak = std::max(peak, live);
+        return true;
     }
 
     /**
      * @brief Update the particle system.
      *
-     * This method updates each particle's state based on the elapsed time (deltaTime)
-     * and removes particles that are no longer alive.
+     * This method spawns the particles of the emitters, then updates every particle's state based
+     * on the elapsed time (deltaTime) with the vector kernel and collides it with the scene field,
+     * in parallel chunks when a pool is set, then resolves the contacts between particles and removes
+     * particles that are no longer alive.
      *
      * @param deltaTime The time elapsed since the last update, in seconds.
      */
     void update(float deltaTime) {
-        // Update each particle's state
-        for (auto& particle : particles) {
-            particle.update(deltaTime);
+        for (Emitter& emitter : emitters) {
+            emitter.spawn(emitter.due(deltaTime, budget.scale), spawnBatch);
+            for (const Particle& particle : spawnBatch) {
+                addParticle(particle);
+            }
+        }
+
+        updateParticlesParallel(streams(), live, bounds, deltaTime, kernel, pool, field.distance != NULL ? &field : NULL);
+        if (contact != PARTICLE_PASS_THROUGH) {
+            resolveContacts();
         }
-        // Remove dead particles
-        particles.erase(std::remove_if(particles.begin(), particles.end(), [](const Particle& p) { return !p.isAlive(); }), particles.end());
+
+        // Remove dead particles, the last particle moves into the freed slot and is checked next
+        size_t i = 0;
+        while (i < live) {
+            if (life[i] > 0.0f) {
+                i++;
+            }
+            else {
+                kill(i);
+            }
+        }
+    }
+
+private:
+    std::vector<int> older, younger; ///< The neighbours of every particle in the age list
+    size_t live = 0; ///< The particles in use, packed at the front of the streams
+    int oldest = PARTICLE_NONE, youngest = PARTICLE_NONE; ///< The ends of the age list
+    std::vector<Particle> spawnBatch; ///< The particles an emitter spawns in the current update
+
+    /**
+     * @brief Pointers to the streams for the update kernel.
+     */
+    ParticleStreams streams() {
+        ParticleStreams s = { posX.data(), posY.data(), posZ.data(), velX.data(), velY.data(), velZ.data(),
+            life.data(), size.data() };
+        return s;
     }
 
+    ParticleGrid grid; ///< The particles by cell, rebuilt by every contact pass
+
     /**
-     * @brief Draw the particle system.
+     * @brief Merge or pop the particles that touch, found with the grid instead of testing every pair.
      *
-     * This method renders each particle as a sphere with a bubble-like appearance.
-     * It uses blending and lighting to achieve a translucent effect.
+     * A particle touches another when the distance between their centers is under the sum of their
+     * radii (half their sizes). A merge keeps the volume and the momentum: the larger particle takes
+     * the volume of both and the velocity weighted by the volumes, the smaller one dies. The particles
+     * are visited in the same order every time, so the result is deterministic.
      */
-    void draw() {
-        // Enable blending to render transparent particles
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glEnable(GL_LIGHTING);
-
-        // Draw each particle
-        for (const auto& particle : particles) {
-            glPushMatrix();
-            glTranslatef(particle.position.x, particle.position.y, particle.position.z); // Move to particle's position
-
-            // Set bubble-like material properties
-            GLfloat diffuse[] = { 1.0f, 1.0f, 1.0f, 0.3f }; // Transparent color
-            GLfloat specular[] = { 1.0f, 1.0f, 1.0f, 0.7f }; // Bright specular highlight
-            GLfloat shininess[] = { 100.0f }; // Shiny surface
-
-            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
-
-            // Draw the particle as a sphere
-            GLUquadric* quad = gluNewQuadric(); // Create a new quadratic object for drawing
-            gluQuadricNormals(quad, GLU_SMOOTH); // Smooth shading for the sphere
-            gluSphere(quad, particle.size * 0.5f, 16, 16); // Draw a sphere with radius based on particle size
-            gluDeleteQuadric(quad); // Clean up the quadratic object
-
-            glPopMatrix();
+    void resolveContacts() {
+        float largest = 0.0f;
+        for (size_t i = 0; i < live; i++) {
+            largest = std::max(largest, size[i]);
+        }
+        grid.build(posX.data(), posY.data(), posZ.data(), live, bounds, largest);
+
+        // the particles that died this step (out of the box or absorbed) and the new ones do not touch anything
+        grid.forEachPair(
+            [this](uint32_t i) { return life[i] > 0.0f && spawnLife[i] - life[i] >= contactDelay ? size[i] * 0.5f : -1.0f; },
+            [this](uint32_t i, uint32_t j, float) {
+                if (contact == PARTICLE_POP) {
+                    life[i] = life[j] = 0.0f;
+                    popped += 2;
+                    return;
+                }
+                uint32_t big = size[i] >= size[j] ? i : j, small = big == i ? j : i;
+                float bigVolume = size[big] * size[big] * size[big], smallVolume = size[small] * size[small] * size[small];
+                float mergedSize = std::cbrt(bigVolume + smallVolume);
+                if (mergedSize > maxMergedSize) {
+                    life[i] = life[j] = 0.0f;
+                    popped += 2;
+                    return;
+                }
+                float total = bigVolume + smallVolume;
+                velX[big] = (velX[big] * bigVolume + velX[small] * smallVolume) / total;
+                velY[big] = (velY[big] * bigVolume + velY[small] * smallVolume) / total;
+                velZ[big] = (velZ[big] * bigVolume + velZ[small] * smallVolume) / total;
+                size[big] = mergedSize;
+                life[small] = 0.0f;
+                merged++;
+            });
+    }
+
+    /**
+     * @brief Remove a particle, moving the last live particle into its slot.
+     */
+    void kill(size_t i) {
+        // unlink the particle from the age list
+        int before = older[i], after = younger[i];
+        (before != PARTICLE_NONE ? younger[before] : oldest) = after;
+        (after != PARTICLE_NONE ? older[after] : youngest) = before;
+
+        size_t last = --live;
+        if (i == last) {
+            return;
         }
+        posX[i] = posX[last]; posY[i] = posY[last]; posZ[i] = posZ[last];
+        velX[i] = velX[last]; velY[i] = velY[last]; velZ[i] = velZ[last];
+        life[i] = life[last];
+        spawnLife[i] = spawnLife[last];
+        size[i] = size[last];
+        color[i] = color[last];
 
-        glDisable(GL_BLEND); // Disable blending after drawing
+        // the neighbours of the moved particle point to its new slot
+        older[i] = older[last];
+        younger[i] = younger[last];
+        (older[i] != PARTICLE_NONE ? younger[older[i]] : oldest) = (int)i;
+        (younger[i] != PARTICLE_NONE ? older[younger[i]] : youngest) = (int)i;
     }
 };
 
@@ -0,0 +1,92 @@
+#include "Random.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+static uint64_t globalSeed = 0;
+
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint32_t rotate(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+RandomStream::RandomStream(uint64_t seed) {
+    uint64_t a = splitmix64(seed), b = splitmix64(seed);
+    this->state[0] = (uint32_t)a;
+    this->state[1] = (uint32_t)(a >> 32);
+    this->state[2] = (uint32_t)b;
+    this->state[3] = (uint32_t)(b >> 32);
+}
+
+uint32_t RandomStream::next() {
+    uint32_t* s = this->state;
+    uint32_t result = rotate(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotate(s[3], 11);
+    return result;
+}
+
+void RandomStream::fill(float* values, size_t count) {
+    // the state stays in registers for the whole batch instead of going through memory for every value
+    uint32_t s0 = this->state[0], s1 = this->state[1], s2 = this->state[2], s3 = this->state[3];
+    for (size_t i = 0; i < count; i++) {
+        uint32_t result = rotate(s1 * 5, 7) * 9;
+        uint32_t t = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rotate(s3, 11);
+        values[i] = (result >> 8) * (1.0f / 16777216.0f);
+    }
+    this->state[0] = s0;
+    this->state[1] = s1;
+    this->state[2] = s2;
+    this->state[3] = s3;
+}
+
+void Random::setSeed(uint64_t seed) {
+    globalSeed = seed;
+}
+
+uint64_t Random::seed() {
+    return globalSeed;
+}
+
+uint64_t Random::parseSeed(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            return strtoull(argv[i + 1], NULL, 10);
+        }
+    }
+    return (uint64_t)chrono::system_clock::now().time_since_epoch().count();
+}
+
+RandomStream Random::stream(const char* name, uint64_t index) {
+    // FNV-1a of the name, mixed with the seed and the index
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* c = name; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+    }
+    uint64_t mixed = globalSeed ^ hash;
+    return RandomStream(splitmix64(mixed) + index * 0x9E3779B97F4A7C15ull);
+}
+
+RandomStream& Random::local() {
+    static atomic<uint64_t> threads(0);
+    thread_local RandomStream stream = Random::stream("thread", threads++);
+    return stream;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// A fast random generator (xoshiro128**, 128 bits of state) that is cheap to copy and to give to
+// every user that needs its own repeatable sequence. Not thread safe: a stream belongs to one thread.
+class RandomStream {
+public:
+    RandomStream(uint64_t seed = 0); // the state is spread from the seed with splitmix64
+
+    uint32_t next(); // 32 random bits
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); } // in [0, 1)
+    float uniform(float low, float high) { return low + (high - low) * uniform(); } // in [low, high)
+    void fill(float* values, size_t count); // count values in [0, 1), for spawning many particles at once
+
+private:
+    uint32_t state[4];
+};
+
+// The random numbers of the program, all derived from one seed so a run can be repeated exactly
+// (--seed on the command line, the time otherwise).
+// stream() gives the same sequence for the same name and index whatever the threads do, so the
+// simulation uses named streams; local() is a stream per thread for everything else.
+class Random {
+public:
+    static void setSeed(uint64_t seed); // set before anything random is drawn
+    static uint64_t seed();
+    static uint64_t parseSeed(int argc, char** argv); // the value of --seed, or a seed from the time
+    static RandomStream stream(const char* name, uint64_t index = 0); // a stream of its own for a user of random numbers
+    static RandomStream& local(); // the stream of the calling thread (threads are numbered in the order they first ask)
+};
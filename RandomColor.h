@@ -1,19 +1,7 @@
 #ifndef RANDOMCOLOR_H
 #define RANDOMCOLOR_H
 
-#include <cstdlib>
-#include <ctime>
-
-// Initialize random seed for generating random colors
-// This function ensures that the random number generator is seeded only once
-// to avoid generating the same sequence of random numbers on each run.
-inline void initRandomSeed() {
-    static bool initialized = false; // Flag to ensure initialization happens only once
-    if (!initialized) {
-        std::srand(static_cast<unsigned int>(std::time(0))); // Seed the random number generator with the current time
-        initialized = true; // Set the flag to true to prevent re-initialization
-    }
-}
+#include "Random.h"
 
 /**
  * @brief Generate a random color.
@@ -26,9 +14,10 @@ inline void initRandomSeed() {
  * @param b Reference to the blue component of the color.
  */
 inline void generateRandomColor(GLfloat& r, GLfloat& g, GLfloat& b) {
-    r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX); // Generate random red component
-    g = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX); // Generate random green component
-    b = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX); // Generate random blue component
+    RandomStream& random = Random::local(); // the colors follow the seed of the run
+    r = random.uniform(); // Generate random red component
+    g = random.uniform(); // Generate random green component
+    b = random.uniform(); // Generate random blue component
 }
 
 #endif // RANDOMCOLOR_H
@@ -5,21 +5,12 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <GL/glut.h>
-// Define angle limits
-const float LEFT_UPPER_ARM_MIN = -30.0f; // Shoulder joint: more realistic min angle
-const float LEFT_UPPER_ARM_MAX = 180.0f;  // Shoulder joint: more realistic max angle
-const float RIGHT_UPPER_ARM_MIN = -30.0f; // Shoulder joint: more realistic min angle
-const float RIGHT_UPPER_ARM_MAX = 180.0f;  // Shoulder joint: more realistic max angle
+#include "RobotRig.h"
+#include "RobotMesh.h"
+#include <memory>
+// Bounding sphere of the robot: around its joints, plus the thickest part
+const float ROBOT_BOUNDS_MARGIN = 0.9f;
 
-const float LEFT_LOWER_ARM_MIN = 0.0f;   // Elbow joint: realistic min angle (fully extended)
-const float LEFT_LOWER_ARM_MAX = 150.0f; // Elbow joint: realistic max angle (bent)
-const float RIGHT_LOWER_ARM_MIN = 0.0f;  // Elbow joint: realistic min angle (fully extended)
-const float RIGHT_LOWER_ARM_MAX = 150.0f; // Elbow joint: realistic max angle (bent)
-
-const float LEFT_WRIST_MIN = -30.0f; // Wrist joint: realistic min angle
-const float LEFT_WRIST_MAX = 30.0f;  // Wrist joint: realistic max angle
-const float RIGHT_WRIST_MIN = -30.0f; // Wrist joint: realistic min angle
-const float RIGHT_WRIST_MAX = 30.0f;  // Wrist joint: realistic max angle
 class Robot {
 public:
     Robot();
@@ -36,39 +27,24 @@ public:
     void setPosition(float x, float y, float z);
     void setDirection(float angle);
     void getView(float& eyeX, float& eyeY, float& eyeZ, float& centerX, float& centerY, float& centerZ);
-    glm::vec3 getViewPos() ;
+    glm::vec3 getViewPos(); // between the eyes
     glm::vec3 getViewTarget();
-    glm::vec3 getViewVector();
+    glm::vec3 getViewVector(); // where the face looks
+    glm::vec3 getHandPosition(bool left); // the tips of the fingers
     float getPositionX() const;
     float getPositionY() const;
     float getPositionZ() const;
     float getDirection() const;
+    void getBounds(glm::vec3& center, float& radius); // bounding sphere in world space
+    const Skeleton& getSkeleton() const { return skeleton; }
+    size_t jointsRecomputed() const { return skeleton.recomputed; } // joint matrices recomputed since the start
 
 private:
-    void drawBody();
-    void drawLegs();
-    void drawArms();
-    void drawHead();
     void rotateLeg(float angle, bool left); // Updated function for leg rotation
 
-
-    float centerX;
-    float centerY;
-    float centerZ;
-    float eyeX, eyeY, eyeZ;
-    float posX, posY, posZ;
-    float directionAngle;
-    float headVerticalAngle, headHorizontalAngle;
-    float leftUpperArmAngle, leftLowerArmAngle, leftWristAngle;
-    float rightUpperArmAngle, rightLowerArmAngle, rightWristAngle;
-    float leftUpperLegAngle, leftLowerLegAngle, leftAnkleAngle;
-    float rightUpperLegAngle, rightLowerLegAngle, rightAnkleAngle;
-    float leftFootAngle, rightFootAngle; // Variables for foot angles
-    float leftFootY, rightFootY; // Variables for foot positions
-    float legWalkingAngle;
+    Skeleton skeleton; // every angle and the position live in the joints
+    unique_ptr<RobotMesh> mesh; // the parts tessellated once, its buffer is freed with the robot
     float walkingPhase=0;
-
-
 };
 
 #endif
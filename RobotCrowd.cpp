@@ -0,0 +1,304 @@
+#include "RobotCrowd.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CROWD_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define CROWD_AVX2_TARGET
+#else
+#define CROWD_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// the sine of the vector kernels: x is brought to [-pi, pi] with a two part 2 pi, folded to [-pi / 2, pi / 2]
+// and the Taylor series taken to the 11th power (error under 1e-6)
+const float CROWD_INV_TWO_PI = 0.15915494309189535f;
+const float CROWD_TWO_PI_HI = 6.28125f, CROWD_TWO_PI_LO = 0.0019353071795864769f;
+const float CROWD_PI = 3.14159265358979324f, CROWD_HALF_PI = 1.57079632679489662f;
+const float CROWD_S3 = -1.0f / 6.0f, CROWD_S5 = 1.0f / 120.0f, CROWD_S7 = -1.0f / 5040.0f;
+const float CROWD_S9 = 1.0f / 362880.0f, CROWD_S11 = -1.0f / 39916800.0f;
+const float CROWD_DEGREES = CROWD_PI / 180.0f;
+
+// the streams of the kernels, from index 0
+struct CrowdStreams {
+    const float* facing;
+    const float* phase;
+    const float* tempo;
+    float* angle[CROWD_CHANNELS];
+    float* sine[CROWD_CHANNELS];
+    float* cosine[CROWD_CHANNELS];
+};
+
+static float sinScalar(float x) {
+    float k = nearbyintf(x * CROWD_INV_TWO_PI);
+    float r = (x - k * CROWD_TWO_PI_HI) - k * CROWD_TWO_PI_LO;
+    r = r > CROWD_HALF_PI ? CROWD_PI - r : r;
+    r = r < -CROWD_HALF_PI ? -CROWD_PI - r : r;
+    float r2 = r * r;
+    return r * (1.0f + r2 * (CROWD_S3 + r2 * (CROWD_S5 + r2 * (CROWD_S7 + r2 * (CROWD_S9 + r2 * CROWD_S11)))));
+}
+
+// the reference kernel, also used for the robots left over by the vector kernels
+static void danceScalar(const CrowdStreams& c, size_t i, size_t end, float time) {
+    for (; i < end; i++) {
+        float t = time * c.tempo[i] + c.phase[i];
+        float s15 = sinScalar(t * 1.5f), s2 = sinScalar(t * 2.0f), s25 = sinScalar(t * 2.5f);
+        float s3 = sinScalar(t * 3.0f), s35 = sinScalar(t * 3.5f);
+        c.angle[CROWD_ROOT][i] = c.facing[i] + 10.0f * s15;
+        c.angle[CROWD_HEAD_TURN][i] = 15.0f * s2;
+        c.angle[CROWD_HEAD_NOD][i] = 10.0f * s3;
+        c.angle[CROWD_LEFT_SHOULDER][i] = 45.0f + 30.0f * s25;
+        c.angle[CROWD_RIGHT_SHOULDER][i] = 45.0f - 30.0f * s25; // half a turn behind the left one
+        c.angle[CROWD_LEFT_ELBOW][i] = 20.0f + 20.0f * s35;
+        c.angle[CROWD_RIGHT_ELBOW][i] = 20.0f - 20.0f * s35;
+        c.angle[CROWD_LEFT_HIP][i] = 10.0f * s2;
+        c.angle[CROWD_RIGHT_HIP][i] = -10.0f * s2;
+    }
+}
+
+static void sinCosScalar(const float* angle, float* sine, float* cosine, size_t i, size_t end) {
+    for (; i < end; i++) {
+        float r = angle[i] * CROWD_DEGREES;
+        sine[i] = sinScalar(r);
+        cosine[i] = sinScalar(r + CROWD_HALF_PI);
+    }
+}
+
+#ifdef CROWD_SIMD
+static inline __m128 sinSse(__m128 x) {
+    __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(CROWD_INV_TWO_PI)))); // rounds to nearest
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(CROWD_TWO_PI_HI))), _mm_mul_ps(k, _mm_set1_ps(CROWD_TWO_PI_LO)));
+    __m128 over = _mm_cmpgt_ps(r, _mm_set1_ps(CROWD_HALF_PI));
+    r = _mm_or_ps(_mm_and_ps(over, _mm_sub_ps(_mm_set1_ps(CROWD_PI), r)), _mm_andnot_ps(over, r));
+    __m128 under = _mm_cmplt_ps(r, _mm_set1_ps(-CROWD_HALF_PI));
+    r = _mm_or_ps(_mm_and_ps(under, _mm_sub_ps(_mm_set1_ps(-CROWD_PI), r)), _mm_andnot_ps(under, r));
+    __m128 r2 = _mm_mul_ps(r, r);
+    __m128 p = _mm_add_ps(_mm_set1_ps(CROWD_S9), _mm_mul_ps(r2, _mm_set1_ps(CROWD_S11)));
+    p = _mm_add_ps(_mm_set1_ps(CROWD_S7), _mm_mul_ps(r2, p));
+    p = _mm_add_ps(_mm_set1_ps(CROWD_S5), _mm_mul_ps(r2, p));
+    p = _mm_add_ps(_mm_set1_ps(CROWD_S3), _mm_mul_ps(r2, p));
+    p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, p));
+    return _mm_mul_ps(r, p);
+}
+
+static void danceSse(const CrowdStreams& c, size_t i, size_t end, float time) {
+    const __m128 now = _mm_set1_ps(time);
+    for (; i + 4 <= end; i += 4) {
+        __m128 t = _mm_add_ps(_mm_mul_ps(now, _mm_loadu_ps(c.tempo + i)), _mm_loadu_ps(c.phase + i));
+        __m128 s15 = sinSse(_mm_mul_ps(t, _mm_set1_ps(1.5f))), s2 = sinSse(_mm_mul_ps(t, _mm_set1_ps(2.0f)));
+        __m128 s25 = sinSse(_mm_mul_ps(t, _mm_set1_ps(2.5f))), s3 = sinSse(_mm_mul_ps(t, _mm_set1_ps(3.0f)));
+        __m128 s35 = sinSse(_mm_mul_ps(t, _mm_set1_ps(3.5f)));
+        _mm_storeu_ps(c.angle[CROWD_ROOT] + i, _mm_add_ps(_mm_loadu_ps(c.facing + i), _mm_mul_ps(_mm_set1_ps(10.0f), s15)));
+        _mm_storeu_ps(c.angle[CROWD_HEAD_TURN] + i, _mm_mul_ps(_mm_set1_ps(15.0f), s2));
+        _mm_storeu_ps(c.angle[CROWD_HEAD_NOD] + i, _mm_mul_ps(_mm_set1_ps(10.0f), s3));
+        _mm_storeu_ps(c.angle[CROWD_LEFT_SHOULDER] + i, _mm_add_ps(_mm_set1_ps(45.0f), _mm_mul_ps(_mm_set1_ps(30.0f), s25)));
+        _mm_storeu_ps(c.angle[CROWD_RIGHT_SHOULDER] + i, _mm_sub_ps(_mm_set1_ps(45.0f), _mm_mul_ps(_mm_set1_ps(30.0f), s25)));
+        _mm_storeu_ps(c.angle[CROWD_LEFT_ELBOW] + i, _mm_add_ps(_mm_set1_ps(20.0f), _mm_mul_ps(_mm_set1_ps(20.0f), s35)));
+        _mm_storeu_ps(c.angle[CROWD_RIGHT_ELBOW] + i, _mm_sub_ps(_mm_set1_ps(20.0f), _mm_mul_ps(_mm_set1_ps(20.0f), s35)));
+        _mm_storeu_ps(c.angle[CROWD_LEFT_HIP] + i, _mm_mul_ps(_mm_set1_ps(10.0f), s2));
+        _mm_storeu_ps(c.angle[CROWD_RIGHT_HIP] + i, _mm_mul_ps(_mm_set1_ps(-10.0f), s2));
+    }
+    danceScalar(c, i, end, time);
+}
+
+static void sinCosSse(const float* angle, float* sine, float* cosine, size_t i, size_t end) {
+    for (; i + 4 <= end; i += 4) {
+        __m128 r = _mm_mul_ps(_mm_loadu_ps(angle + i), _mm_set1_ps(CROWD_DEGREES));
+        _mm_storeu_ps(sine + i, sinSse(r));
+        _mm_storeu_ps(cosine + i, sinSse(_mm_add_ps(r, _mm_set1_ps(CROWD_HALF_PI))));
+    }
+    sinCosScalar(angle, sine, cosine, i, end);
+}
+
+CROWD_AVX2_TARGET
+static inline __m256 sinAvx2(__m256 x) {
+    __m256 k = _mm256_cvtepi32_ps(_mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(CROWD_INV_TWO_PI))));
+    __m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(CROWD_TWO_PI_HI))), _mm256_mul_ps(k, _mm256_set1_ps(CROWD_TWO_PI_LO)));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(CROWD_PI), r), _mm256_cmp_ps(r, _mm256_set1_ps(CROWD_HALF_PI), _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(-CROWD_PI), r), _mm256_cmp_ps(r, _mm256_set1_ps(-CROWD_HALF_PI), _CMP_LT_OQ));
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 p = _mm256_add_ps(_mm256_set1_ps(CROWD_S9), _mm256_mul_ps(r2, _mm256_set1_ps(CROWD_S11)));
+    p = _mm256_add_ps(_mm256_set1_ps(CROWD_S7), _mm256_mul_ps(r2, p));
+    p = _mm256_add_ps(_mm256_set1_ps(CROWD_S5), _mm256_mul_ps(r2, p));
+    p = _mm256_add_ps(_mm256_set1_ps(CROWD_S3), _mm256_mul_ps(r2, p));
+    p = _mm256_add_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(r2, p));
+    return _mm256_mul_ps(r, p);
+}
+
+CROWD_AVX2_TARGET
+static void danceAvx2(const CrowdStreams& c, size_t i, size_t end, float time) {
+    const __m256 now = _mm256_set1_ps(time);
+    for (; i + 8 <= end; i += 8) {
+        __m256 t = _mm256_add_ps(_mm256_mul_ps(now, _mm256_loadu_ps(c.tempo + i)), _mm256_loadu_ps(c.phase + i));
+        __m256 s15 = sinAvx2(_mm256_mul_ps(t, _mm256_set1_ps(1.5f))), s2 = sinAvx2(_mm256_mul_ps(t, _mm256_set1_ps(2.0f)));
+        __m256 s25 = sinAvx2(_mm256_mul_ps(t, _mm256_set1_ps(2.5f))), s3 = sinAvx2(_mm256_mul_ps(t, _mm256_set1_ps(3.0f)));
+        __m256 s35 = sinAvx2(_mm256_mul_ps(t, _mm256_set1_ps(3.5f)));
+        _mm256_storeu_ps(c.angle[CROWD_ROOT] + i, _mm256_add_ps(_mm256_loadu_ps(c.facing + i), _mm256_mul_ps(_mm256_set1_ps(10.0f), s15)));
+        _mm256_storeu_ps(c.angle[CROWD_HEAD_TURN] + i, _mm256_mul_ps(_mm256_set1_ps(15.0f), s2));
+        _mm256_storeu_ps(c.angle[CROWD_HEAD_NOD] + i, _mm256_mul_ps(_mm256_set1_ps(10.0f), s3));
+        _mm256_storeu_ps(c.angle[CROWD_LEFT_SHOULDER] + i, _mm256_add_ps(_mm256_set1_ps(45.0f), _mm256_mul_ps(_mm256_set1_ps(30.0f), s25)));
+        _mm256_storeu_ps(c.angle[CROWD_RIGHT_SHOULDER] + i, _mm256_sub_ps(_mm256_set1_ps(45.0f), _mm256_mul_ps(_mm256_set1_ps(30.0f), s25)));
+        _mm256_storeu_ps(c.angle[CROWD_LEFT_ELBOW] + i, _mm256_add_ps(_mm256_set1_ps(20.0f), _mm256_mul_ps(_mm256_set1_ps(20.0f), s35)));
+        _mm256_storeu_ps(c.angle[CROWD_RIGHT_ELBOW] + i, _mm256_sub_ps(_mm256_set1_ps(20.0f), _mm256_mul_ps(_mm256_set1_ps(20.0f), s35)));
+        _mm256_storeu_ps(c.angle[CROWD_LEFT_HIP] + i, _mm256_mul_ps(_mm256_set1_ps(10.0f), s2));
+        _mm256_storeu_ps(c.angle[CROWD_RIGHT_HIP] + i, _mm256_mul_ps(_mm256_set1_ps(-10.0f), s2));
+    }
+    danceScalar(c, i, end, time);
+}
+
+CROWD_AVX2_TARGET
+static void sinCosAvx2(const float* angle, float* sine, float* cosine, size_t i, size_t end) {
+    for (; i + 8 <= end; i += 8) {
+        __m256 r = _mm256_mul_ps(_mm256_loadu_ps(angle + i), _mm256_set1_ps(CROWD_DEGREES));
+        _mm256_storeu_ps(sine + i, sinAvx2(r));
+        _mm256_storeu_ps(cosine + i, sinAvx2(_mm256_add_ps(r, _mm256_set1_ps(CROWD_HALF_PI))));
+    }
+    sinCosScalar(angle, sine, cosine, i, end);
+}
+#endif
+
+// the joint each channel moves
+static const RobotJoint CHANNEL_JOINTS[CROWD_CHANNELS] = {
+    ROBOT_ROOT, ROBOT_HEAD_TURN, ROBOT_HEAD_NOD, ROBOT_LEFT_SHOULDER, ROBOT_RIGHT_SHOULDER,
+    ROBOT_LEFT_ELBOW, ROBOT_RIGHT_ELBOW, ROBOT_LEFT_HIP, ROBOT_RIGHT_HIP
+};
+
+// a rotation about a unit axis from the cosine and sine of its angle, as glm::rotate builds it
+static glm::mat4 axisRotation(const glm::vec3& axis, float c, float s) {
+    glm::vec3 t = axis * (1.0f - c);
+    glm::mat4 r(1.0f);
+    r[0] = glm::vec4(c + t.x * axis.x, t.x * axis.y + s * axis.z, t.x * axis.z - s * axis.y, 0.0f);
+    r[1] = glm::vec4(t.y * axis.x - s * axis.z, c + t.y * axis.y, t.y * axis.z + s * axis.x, 0.0f);
+    r[2] = glm::vec4(t.z * axis.x + s * axis.y, t.z * axis.y - s * axis.x, c + t.z * axis.z, 0.0f);
+    return r;
+}
+
+RobotCrowd::RobotCrowd() {
+    Skeleton skeleton;
+    buildRobotSkeleton(skeleton);
+    for (int j = 0; j < ROBOT_JOINTS; j++) {
+        const Joint& joint = skeleton.joint(j);
+        this->rig.push_back(joint);
+        this->rest[j] = glm::rotate(glm::translate(glm::mat4(1.0f), joint.offset), glm::radians(joint.angle), joint.axis);
+        this->channelOf[j] = -1;
+    }
+    for (int c = 0; c < CROWD_CHANNELS; c++) {
+        this->channelOf[CHANNEL_JOINTS[c]] = c;
+    }
+}
+
+void RobotCrowd::populate(size_t count, const glm::vec2& lower, const glm::vec2& upper) {
+    this->x.clear();
+    this->z.clear();
+    this->facing.clear();
+    this->phase.clear();
+    this->tempo.clear();
+    RandomStream random = Random::stream("robot crowd");
+    size_t side = (size_t)ceil(sqrt((double)count));
+    glm::vec2 spacing = (upper - lower) / (float)max(side, (size_t)1);
+    this->scale = min(1.0f, min(spacing.x, spacing.y) / 3.0f); // a robot with its arms out is about 3 wide
+    for (size_t i = 0; i < count; i++) {
+        glm::vec2 cell((float)(i % side), (float)(i / side));
+        glm::vec2 place = lower + (cell + 0.5f) * spacing;
+        this->x.push_back(place.x + random.uniform(-0.25f, 0.25f) * spacing.x);
+        this->z.push_back(place.y + random.uniform(-0.25f, 0.25f) * spacing.y);
+        this->facing.push_back(random.uniform(0.0f, 360.0f));
+        this->phase.push_back(random.uniform(0.0f, 2.0f * CROWD_PI));
+        this->tempo.push_back(random.uniform(0.8f, 1.2f));
+    }
+    for (int c = 0; c < CROWD_CHANNELS; c++) {
+        this->angles[c].assign(count, 0.0f);
+        this->sines[c].assign(count, 0.0f);
+        this->cosines[c].assign(count, 1.0f);
+    }
+    this->worlds.assign(count * ROBOT_JOINTS, glm::mat4(1.0f));
+}
+
+void RobotCrowd::animate(float time, ParticleKernel kernel) {
+    size_t count = size();
+    CrowdStreams streams;
+    streams.facing = this->facing.data();
+    streams.phase = this->phase.data();
+    streams.tempo = this->tempo.data();
+    for (int c = 0; c < CROWD_CHANNELS; c++) {
+        streams.angle[c] = this->angles[c].data();
+        streams.sine[c] = this->sines[c].data();
+        streams.cosine[c] = this->cosines[c].data();
+    }
+    switch (kernel) {
+#ifdef CROWD_SIMD
+    case PARTICLE_KERNEL_AVX2:
+        danceAvx2(streams, 0, count, time);
+        for (int c = 0; c < CROWD_CHANNELS; c++) {
+            sinCosAvx2(streams.angle[c], streams.sine[c], streams.cosine[c], 0, count);
+        }
+        break;
+    case PARTICLE_KERNEL_SSE:
+        danceSse(streams, 0, count, time);
+        for (int c = 0; c < CROWD_CHANNELS; c++) {
+            sinCosSse(streams.angle[c], streams.sine[c], streams.cosine[c], 0, count);
+        }
+        break;
+#endif
+    default:
+        danceScalar(streams, 0, count, time);
+        for (int c = 0; c < CROWD_CHANNELS; c++) {
+            sinCosScalar(streams.angle[c], streams.sine[c], streams.cosine[c], 0, count);
+        }
+        break;
+    }
+}
+
+void RobotCrowd::poseRange(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        glm::mat4* world = &this->worlds[i * ROBOT_JOINTS];
+        for (int j = 0; j < ROBOT_JOINTS; j++) {
+            const Joint& joint = this->rig[j];
+            int channel = this->channelOf[j];
+            glm::mat4 local = this->rest[j];
+            if (channel >= 0) {
+                local = axisRotation(joint.axis, this->cosines[channel][i], this->sines[channel][i]);
+                local[3] = glm::vec4(joint.offset, 1.0f);
+            }
+            if (j == ROBOT_ROOT) {
+                local[0] *= this->scale;
+                local[1] *= this->scale;
+                local[2] *= this->scale;
+                local[3] = glm::vec4(this->x[i], joint.offset.y * this->scale, this->z[i], 1.0f);
+            }
+            world[j] = joint.parent >= 0 ? world[joint.parent] * local : local;
+        }
+    }
+}
+
+void RobotCrowd::pose(ThreadPool* pool) {
+    size_t count = size();
+    size_t chunks = (count + CROWD_CHUNK_SIZE - 1) / CROWD_CHUNK_SIZE;
+    if (pool == NULL || pool->size() == 0 || chunks < 2) {
+        poseRange(0, count);
+        return;
+    }
+
+    // the threads take the next chunk until none is left
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+            poseRange(chunk * CROWD_CHUNK_SIZE, min((chunk + 1) * CROWD_CHUNK_SIZE, count));
+        }
+    };
+    vector<future<void>> helpers;
+    size_t helperCount = min((size_t)pool->size(), chunks - 1);
+    for (size_t i = 0; i < helperCount; i++) {
+        helpers.push_back(pool->submit(work));
+    }
+    work();
+    for (future<void>& helper : helpers) {
+        helper.wait();
+    }
+}
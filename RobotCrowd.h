@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "RobotRig.h"
+#include "ParticleKernels.h"
+
+using namespace std;
+
+class ThreadPool;
+
+// The joints the dance moves, the others keep the angle of the rig
+enum CrowdChannel {
+    CROWD_ROOT, // the facing of the robot plus the twist of the body
+    CROWD_HEAD_TURN, CROWD_HEAD_NOD,
+    CROWD_LEFT_SHOULDER, CROWD_RIGHT_SHOULDER,
+    CROWD_LEFT_ELBOW, CROWD_RIGHT_ELBOW,
+    CROWD_LEFT_HIP, CROWD_RIGHT_HIP,
+    CROWD_CHANNELS
+};
+
+const size_t CROWD_CHUNK_SIZE = 512; // robots per job of the parallel pose (a multiple of the vector width)
+const float CROWD_BOUNDS_HEIGHT = 3.0f; // the bounding sphere of a dancing robot of scale 1, above its position
+const float CROWD_BOUNDS_RADIUS = 4.5f;
+
+// Many robots dancing Robot::dance, each at its own phase and tempo.
+// Everything is stored per joint across the robots (structure of arrays): animate() evaluates the dance of
+// all the robots in vector loops, eight or four robots at a time, writing the angles and their sines and
+// cosines; pose() then chains the joint matrices of every robot (on the pool when there is one).
+// The dance keeps the angles within the limits of the rig, so they are not clamped.
+class RobotCrowd {
+public:
+    RobotCrowd();
+
+    void populate(size_t count, const glm::vec2& lower, const glm::vec2& upper); // robots on a jittered grid over a floor area, sized to fit
+    void animate(float time, ParticleKernel kernel); // the dance of every robot at a time
+    void pose(ThreadPool* pool); // the world matrices of every joint of every robot, from the last animate
+
+    size_t size() const { return this->x.size(); }
+    float scale = 1.0f; // the size of the robots, the same for all
+    const glm::mat4* joints(size_t robot) const { return &this->worlds[robot * ROBOT_JOINTS]; } // ROBOT_JOINTS matrices, after pose
+    glm::vec3 position(size_t robot) const { return glm::vec3(this->x[robot], 0.0f, this->z[robot]); }
+    float angle(CrowdChannel channel, size_t robot) const { return this->angles[channel][robot]; } // degrees
+
+private:
+    vector<float> x, z, facing, phase, tempo; // the place and style of every robot
+    vector<float> angles[CROWD_CHANNELS], sines[CROWD_CHANNELS], cosines[CROWD_CHANNELS]; // per channel, per robot
+    vector<glm::mat4> worlds; // ROBOT_JOINTS per robot
+    vector<Joint> rig; // the joints of a robot at rest
+    glm::mat4 rest[ROBOT_JOINTS]; // the local matrices of the joints the dance does not move
+    int channelOf[ROBOT_JOINTS]; // the channel moving a joint, or -1
+
+    void poseRange(size_t begin, size_t end);
+};
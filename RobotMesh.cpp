@@ -0,0 +1,188 @@
+#include "RobotMesh.h"
+#include "GLExtensions.h"
+#include "ObjectGL.h"
+#include "Frustum.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+#include <cstddef>
+
+static void applyMaterial(RobotMaterial material) {
+    const RobotMaterialColors& colors = ROBOT_MATERIAL_COLORS[material];
+    glMaterialfv(GL_FRONT, GL_AMBIENT, colors.ambient);
+    glMaterialfv(GL_FRONT, GL_DIFFUSE, colors.diffuse);
+    glMaterialfv(GL_FRONT, GL_SPECULAR, colors.specular);
+    glMaterialfv(GL_FRONT, GL_SHININESS, &colors.shininess);
+    glColor3fv(colors.diffuse);
+}
+
+RobotMesh::RobotMesh(int slices) {
+    // a piece for every joint and material, in the material order of the parts
+    const vector<RobotPart>& parts = robotParts();
+    vector<bool> done(parts.size(), false);
+    for (size_t p = 0; p < parts.size(); p++) {
+        if (done[p]) {
+            continue;
+        }
+        Piece piece = { parts[p].joint, parts[p].material, parts[p].detail, (GLint)this->vertices.size(), 0 };
+        for (size_t q = p; q < parts.size(); q++) {
+            if (!done[q] && parts[q].joint == piece.joint && parts[q].material == piece.material && parts[q].detail == piece.detail) {
+                addPart(parts[q], slices);
+                done[q] = true;
+            }
+        }
+        piece.count = (GLsizei)this->vertices.size() - piece.first;
+        this->pieces.push_back(piece);
+    }
+}
+
+RobotMesh::~RobotMesh() {
+    if (this->buffer != 0) {
+        pglDeleteBuffers(1, &this->buffer);
+    }
+}
+
+void RobotMesh::addPart(const RobotPart& part, int slices) {
+    // the normals go through the inverse transpose of the transform, whose columns are the cofactors (up to the determinant)
+    glm::vec3 a(part.transform[0]), b(part.transform[1]), c(part.transform[2]);
+    glm::vec3 cofactors[3] = { glm::cross(b, c), glm::cross(c, a), glm::cross(a, b) };
+    auto emit = [&](const glm::vec3& position, const glm::vec3& normal) {
+        glm::vec3 p = glm::vec3(part.transform * glm::vec4(position, 1.0f));
+        glm::vec3 n = glm::normalize(cofactors[0] * normal.x + cofactors[1] * normal.y + cofactors[2] * normal.z);
+        RobotVertex vertex = { { p.x, p.y, p.z }, { n.x, n.y, n.z } };
+        this->vertices.push_back(vertex);
+    };
+    const float twoPi = 6.28318530717958648f;
+
+    switch (part.shape) {
+    case ROBOT_CUBE: {
+        // glutSolidCube(1): every face split in two counterclockwise triangles, u x v = normal
+        const glm::vec3 faces[6][3] = {
+            { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } }, { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+            { { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } }, { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+            { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } }, { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+        };
+        for (const glm::vec3* face : faces) {
+            glm::vec3 center = face[0] * 0.5f, u = face[1] * 0.5f, v = face[2] * 0.5f;
+            glm::vec3 corners[4] = { center - u - v, center + u - v, center + u + v, center - u + v };
+            const int order[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i : order) {
+                emit(corners[i], face[0]);
+            }
+        }
+        break;
+    }
+    case ROBOT_CYLINDER:
+        // gluCylinder with one stack and no caps, along z from 0 to the height
+        for (int i = 0; i < slices; i++) {
+            float a0 = twoPi * i / slices, a1 = twoPi * (i + 1) / slices;
+            glm::vec3 n0(cosf(a0), sinf(a0), 0.0f), n1(cosf(a1), sinf(a1), 0.0f);
+            glm::vec3 b0 = n0 * part.radius, b1 = n1 * part.radius, up(0.0f, 0.0f, part.height);
+            emit(b0, n0); emit(b1, n1); emit(b1 + up, n1);
+            emit(b0, n0); emit(b1 + up, n1); emit(b0 + up, n0);
+        }
+        break;
+    case ROBOT_SPHERE:
+        // glutSolidSphere: as many stacks as slices, the poles on z
+        for (int j = 0; j < slices; j++) {
+            float t0 = twoPi * 0.5f * j / slices - twoPi * 0.25f, t1 = twoPi * 0.5f * (j + 1) / slices - twoPi * 0.25f;
+            for (int i = 0; i < slices; i++) {
+                float a0 = twoPi * i / slices, a1 = twoPi * (i + 1) / slices;
+                glm::vec3 n00(cosf(t0) * cosf(a0), cosf(t0) * sinf(a0), sinf(t0)), n01(cosf(t0) * cosf(a1), cosf(t0) * sinf(a1), sinf(t0));
+                glm::vec3 n11(cosf(t1) * cosf(a1), cosf(t1) * sinf(a1), sinf(t1)), n10(cosf(t1) * cosf(a0), cosf(t1) * sinf(a0), sinf(t1));
+                if (j > 0) { // the bottom cap has no first triangle
+                    emit(n00 * part.radius, n00); emit(n01 * part.radius, n01); emit(n11 * part.radius, n11);
+                }
+                if (j < slices - 1) { // the top cap has no second triangle
+                    emit(n00 * part.radius, n00); emit(n11 * part.radius, n11); emit(n10 * part.radius, n10);
+                }
+            }
+        }
+        break;
+    }
+}
+
+void RobotMesh::bind() {
+    if (!this->uploaded) {
+        this->uploaded = true;
+        if (loadGLExtensions() && !this->vertices.empty()) {
+            pglGenBuffers(1, &this->buffer);
+            pglBindBuffer(GL_ARRAY_BUFFER, this->buffer);
+            pglBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(RobotVertex), this->vertices.data(), GL_STATIC_DRAW);
+        }
+    }
+    const char* base = NULL; // offsets are relative to the bound buffer
+    if (this->buffer != 0) {
+        pglBindBuffer(GL_ARRAY_BUFFER, this->buffer);
+    }
+    else {
+        base = reinterpret_cast<const char*>(this->vertices.data());
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RobotVertex), base + offsetof(RobotVertex, position));
+    glNormalPointer(GL_FLOAT, sizeof(RobotVertex), base + offsetof(RobotVertex, normal));
+}
+
+void RobotMesh::unbind() {
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    if (this->buffer != 0) {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void RobotMesh::draw(const vector<const glm::mat4*>& robots, bool detail) {
+    this->drawCalls = 0;
+    drawList(robots, detail);
+}
+
+void RobotMesh::drawList(const vector<const glm::mat4*>& robots, bool detail) {
+    if (robots.empty()) {
+        return;
+    }
+    GLfloat modelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glm::mat4 base = glm::make_mat4(modelview);
+    glPushMatrix();
+    bind();
+
+    int material = -1;
+    for (const Piece& piece : this->pieces) {
+        if (piece.detail && !detail) {
+            continue;
+        }
+        if (piece.material != material) {
+            material = piece.material;
+            applyMaterial(piece.material);
+        }
+        for (const glm::mat4* joints : robots) {
+            glLoadMatrixf(glm::value_ptr(base * joints[piece.joint]));
+            glDrawArrays(GL_TRIANGLES, piece.first, piece.count);
+        }
+        this->drawCalls += (int)robots.size();
+    }
+
+    unbind();
+    glPopMatrix();
+}
+
+void RobotMesh::drawCrowd(const RobotCrowd& crowd, const glm::vec3& eye) {
+    this->robotsDrawn = this->robotsCulled = this->robotsDetailed = this->drawCalls = 0;
+    this->nearRobots.clear();
+    this->farRobots.clear();
+    Frustum frustum = Frustum::current();
+    float radius = CROWD_BOUNDS_RADIUS * crowd.scale, detailDistance = CROWD_DETAIL_DISTANCE * crowd.scale;
+    for (size_t i = 0; i < crowd.size(); i++) {
+        glm::vec3 center = crowd.position(i) + glm::vec3(0.0f, CROWD_BOUNDS_HEIGHT * crowd.scale, 0.0f);
+        if (ObjectGL::cullingEnabled && !frustum.containsSphere(center, radius)) {
+            this->robotsCulled++;
+            continue;
+        }
+        glm::vec3 toEye = center - eye;
+        (glm::dot(toEye, toEye) < detailDistance * detailDistance ? this->nearRobots : this->farRobots).push_back(crowd.joints(i));
+    }
+    this->robotsDrawn = (int)(this->nearRobots.size() + this->farRobots.size());
+    this->robotsDetailed = (int)this->nearRobots.size();
+    drawList(this->nearRobots, true);
+    drawList(this->farRobots, false);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "RobotRig.h"
+#include "RobotCrowd.h"
+
+using namespace std;
+
+const int ROBOT_MESH_SLICES = 20; // as fine as the glutSolidSphere and gluCylinder the robot used to be drawn with
+const int CROWD_MESH_SLICES = 8; // coarser for the crowd, whose robots are small
+const float CROWD_DETAIL_DISTANCE = 12.0f; // farther robots of the crowd leave out their detail parts (times the robot scale)
+
+// The parts of the robot tessellated once into a vertex buffer, for drawing many robots.
+// The parts attached to the same joint with the same material are merged into a piece, with their transform
+// baked into the vertices, so a piece is drawn with the matrix of its joint alone. The robots are drawn
+// piece by piece: the buffer is bound once, the material is set once per material and every robot only
+// loads its joint matrix before drawing the piece.
+class RobotMesh {
+public:
+    explicit RobotMesh(int slices);
+    RobotMesh(const RobotMesh&) = delete; // owns an opengl buffer
+    RobotMesh& operator=(const RobotMesh&) = delete;
+    ~RobotMesh();
+
+    void draw(const vector<const glm::mat4*>& robots, bool detail); // the robots (ROBOT_JOINTS joint matrices each), with or without the detail parts
+    void drawCrowd(const RobotCrowd& crowd, const glm::vec3& eye); // every robot of the crowd in the view, the near ones in detail
+
+    size_t vertexCount() const { return this->vertices.size(); }
+    int robotsDrawn = 0; // in the last drawCrowd
+    int robotsCulled = 0;
+    int robotsDetailed = 0;
+    int drawCalls = 0; // in the last draw or drawCrowd, one per piece and robot
+
+private:
+    struct RobotVertex {
+        GLfloat position[3];
+        GLfloat normal[3];
+    };
+    struct Piece {
+        RobotJoint joint;
+        RobotMaterial material;
+        bool detail;
+        GLint first; // the first vertex
+        GLsizei count;
+    };
+
+    vector<RobotVertex> vertices; // triangles, piece after piece
+    vector<Piece> pieces; // in material order
+    GLuint buffer = 0;
+    bool uploaded = false;
+    vector<const glm::mat4*> nearRobots, farRobots; // the lists of the last drawCrowd
+
+    void addPart(const RobotPart& part, int slices);
+    void drawList(const vector<const glm::mat4*>& robots, bool detail); // adds to the draw calls
+    void bind();
+    void unbind();
+};
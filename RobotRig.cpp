@@ -0,0 +1,104 @@
+#include "RobotRig.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+// Proportions of the robot
+static const float BODY_WIDTH = 1.5f, BODY_HEIGHT = 3.0f, BODY_DEPTH = 0.8f;
+static const float BODY_CENTER = 2.5f; // height of the body center above the position
+static const float LEG_WIDTH = BODY_WIDTH * 0.3f, LEG_HEIGHT = 1.5f, LEG_DEPTH = 0.4f;
+static const float FOOT_WIDTH = LEG_WIDTH, FOOT_HEIGHT = LEG_HEIGHT * 0.2f, FOOT_DEPTH = LEG_DEPTH * 1.5f;
+static const float UPPER_ARM_RADIUS = 0.2f, UPPER_ARM_HEIGHT = 1.2f;
+static const float LOWER_ARM_RADIUS = UPPER_ARM_RADIUS * 0.8f, LOWER_ARM_HEIGHT = UPPER_ARM_HEIGHT;
+static const float WRIST_WIDTH = (LOWER_ARM_RADIUS * 2) * 1.2f, WRIST_HEIGHT = LOWER_ARM_HEIGHT * 0.35f, WRIST_DEPTH = LOWER_ARM_RADIUS;
+static const float FINGER_RADIUS = LOWER_ARM_RADIUS * 0.4f, FINGER_HEIGHT = WRIST_HEIGHT;
+static const float NECK_RADIUS = 0.2f, NECK_HEIGHT = 0.35f;
+static const float HEAD_WIDTH = 0.6f, HEAD_HEIGHT = 0.7f, HEAD_DEPTH = 0.35f;
+static const float EYES_RADIUS = 0.1f, EYES_DISTANCE = 0.45f, EYES_HEIGHT = 0.7f, PUPILS_RADIUS = 0.5f; // proportional to the head and eyes
+static const float MOUTH_WIDTH = 0.5f, MOUTH_HEIGHT = 0.00001f;
+
+const glm::vec3 ROBOT_EYES(0.0f, -(HEAD_DEPTH / 2), EYES_HEIGHT * HEAD_HEIGHT);
+const glm::vec3 ROBOT_HEAD_TOP(0.0f, 0.0f, HEAD_HEIGHT);
+const glm::vec3 ROBOT_FINGERTIPS(0.0f, 0.0f, -WRIST_HEIGHT - FINGER_HEIGHT);
+
+const RobotMaterialColors ROBOT_MATERIAL_COLORS[ROBOT_MATERIALS] = {
+    { { 0.5f, 0.5f, 0.5f, 1.0f }, { 0.4f, 0.4f, 0.4f, 1.0f }, { 0.774597f, 0.774597f, 0.774597f, 1.0f }, 76.8f }, // High value for a shiny effect
+    { { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, 50.0f },
+    { { 0.0f, 0.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f }, 50.0f },
+    { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, 50.0f },
+};
+
+void buildRobotSkeleton(Skeleton& skeleton) {
+    const glm::vec3 xAxis(-1.0f, 0.0f, 0.0f); // the limbs swing forward for a positive angle
+    skeleton.addJoint(-1, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    skeleton.addJoint(ROBOT_ROOT, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 270.0f, 270.0f, 270.0f);
+    for (int side = 0; side < 2; side++) {
+        float outward = side == 1 ? -1.0f : 1.0f;
+        int hip = skeleton.addJoint(ROBOT_TORSO, glm::vec3(outward * BODY_WIDTH * 0.25f, 0.0f, BODY_CENTER - (BODY_HEIGHT / 2) - 0.7f), xAxis);
+        skeleton.addJoint(hip, glm::vec3(0.0f, 0.0f, -LEG_HEIGHT / 2 - FOOT_HEIGHT / 2), xAxis); // at the bottom of the leg
+    }
+    for (int side = 0; side < 2; side++) {
+        bool left = side == 1;
+        float outward = left ? -1.0f : 1.0f;
+        int shoulder = skeleton.addJoint(ROBOT_TORSO, glm::vec3(outward * (BODY_WIDTH / 2 + UPPER_ARM_RADIUS), 0.0f, BODY_CENTER - (BODY_HEIGHT / 2) + BODY_HEIGHT * 0.95f),
+            xAxis, 0.0f, left ? LEFT_UPPER_ARM_MIN : RIGHT_UPPER_ARM_MIN, left ? LEFT_UPPER_ARM_MAX : RIGHT_UPPER_ARM_MAX);
+        int elbow = skeleton.addJoint(shoulder, glm::vec3(0.0f, 0.0f, -UPPER_ARM_HEIGHT),
+            xAxis, 0.0f, left ? LEFT_LOWER_ARM_MIN : RIGHT_LOWER_ARM_MIN, left ? LEFT_LOWER_ARM_MAX : RIGHT_LOWER_ARM_MAX);
+        skeleton.addJoint(elbow, glm::vec3(0.0f, 0.0f, -LOWER_ARM_HEIGHT),
+            xAxis, 0.0f, left ? LEFT_WRIST_MIN : RIGHT_WRIST_MIN, left ? LEFT_WRIST_MAX : RIGHT_WRIST_MAX);
+    }
+    skeleton.addJoint(ROBOT_TORSO, glm::vec3(0.0f, 0.0f, BODY_CENTER + BODY_HEIGHT / 2), glm::vec3(0.0f, 0.0f, 1.0f), 0.0f, 0.0f, 0.0f);
+    skeleton.addJoint(ROBOT_NECK, glm::vec3(0.0f, 0.0f, NECK_HEIGHT), glm::vec3(0.0f, 0.0f, -1.0f));
+    skeleton.addJoint(ROBOT_HEAD_TURN, glm::vec3(0.0f), xAxis);
+}
+
+static glm::mat4 translation(float x, float y, float z) {
+    return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+}
+
+static glm::mat4 box(const glm::mat4& at, float width, float depth, float height) {
+    return glm::scale(at, glm::vec3(width, depth, height));
+}
+
+const vector<RobotPart>& robotParts() {
+    static vector<RobotPart> parts;
+    if (!parts.empty()) {
+        return parts;
+    }
+    auto add = [](RobotJoint joint, RobotShape shape, RobotMaterial material, const glm::mat4& transform, float radius = 0.0f, float height = 0.0f,
+        bool detail = false) {
+        RobotPart part = { joint, shape, material, transform, radius, height, detail };
+        parts.push_back(part);
+    };
+
+    add(ROBOT_TORSO, ROBOT_CUBE, ROBOT_METAL, box(translation(0.0f, 0.0f, BODY_CENTER), BODY_WIDTH, BODY_DEPTH, BODY_HEIGHT));
+    for (int side = 0; side < 2; side++) {
+        bool left = side == 1;
+        float outward = left ? -1.0f : 1.0f; // the right side is toward +x
+        // leg and foot
+        add(left ? ROBOT_LEFT_HIP : ROBOT_RIGHT_HIP, ROBOT_CUBE, ROBOT_METAL, box(glm::mat4(1.0f), LEG_WIDTH, LEG_DEPTH, LEG_HEIGHT));
+        add(left ? ROBOT_LEFT_FOOT : ROBOT_RIGHT_FOOT, ROBOT_CUBE, ROBOT_METAL, box(glm::mat4(1.0f), FOOT_WIDTH, FOOT_HEIGHT * 2, FOOT_DEPTH * 0.5f));
+        // arm, hanging down from each joint
+        add(left ? ROBOT_LEFT_SHOULDER : ROBOT_RIGHT_SHOULDER, ROBOT_CYLINDER, ROBOT_METAL, translation(0.0f, 0.0f, -UPPER_ARM_HEIGHT),
+            UPPER_ARM_RADIUS, UPPER_ARM_HEIGHT);
+        add(left ? ROBOT_LEFT_ELBOW : ROBOT_RIGHT_ELBOW, ROBOT_CYLINDER, ROBOT_METAL, translation(0.0f, 0.0f, -LOWER_ARM_HEIGHT),
+            LOWER_ARM_RADIUS, LOWER_ARM_HEIGHT);
+        RobotJoint wrist = left ? ROBOT_LEFT_WRIST : ROBOT_RIGHT_WRIST;
+        add(wrist, ROBOT_CUBE, ROBOT_METAL, box(translation(0.0f, 0.0f, -WRIST_HEIGHT / 2), WRIST_WIDTH, WRIST_DEPTH, WRIST_HEIGHT));
+        for (int i = 0; i < 4; i++) {
+            float x = outward * (WRIST_WIDTH / 2 - FINGER_RADIUS - i * WRIST_WIDTH / 4);
+            add(wrist, ROBOT_CYLINDER, ROBOT_METAL, translation(x, 0.0f, -WRIST_HEIGHT - FINGER_HEIGHT), FINGER_RADIUS, FINGER_HEIGHT, true);
+        }
+    }
+    add(ROBOT_NECK, ROBOT_CYLINDER, ROBOT_METAL, glm::mat4(1.0f), NECK_RADIUS, NECK_HEIGHT);
+    add(ROBOT_HEAD_NOD, ROBOT_CUBE, ROBOT_METAL, box(translation(0.0f, 0.0f, HEAD_HEIGHT / 2), HEAD_WIDTH, HEAD_DEPTH, HEAD_HEIGHT));
+
+    // the eyes and the mouth on the face, toward -y
+    float eyeX = (HEAD_WIDTH / 2) * EYES_DISTANCE, eyeZ = EYES_HEIGHT * HEAD_HEIGHT;
+    for (float x : { eyeX, -eyeX }) {
+        add(ROBOT_HEAD_NOD, ROBOT_SPHERE, ROBOT_EYE_WHITE, translation(x, -(HEAD_DEPTH / 2), eyeZ), EYES_RADIUS, 0.0f, true);
+    }
+    for (float x : { eyeX, -eyeX }) {
+        add(ROBOT_HEAD_NOD, ROBOT_SPHERE, ROBOT_PUPIL, translation(x, -(HEAD_DEPTH / 2) - EYES_RADIUS * 0.6f, eyeZ), PUPILS_RADIUS * EYES_RADIUS, 0.0f, true);
+    }
+    add(ROBOT_HEAD_NOD, ROBOT_CUBE, ROBOT_MOUTH, box(translation(0.0f, -(HEAD_DEPTH / 2), HEAD_HEIGHT * 0.3f), MOUTH_WIDTH, MOUTH_HEIGHT, 0.07f), 0.0f, 0.0f, true);
+    return parts;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Skeleton.h"
+
+using namespace std;
+
+// Define angle limits
+const float LEFT_UPPER_ARM_MIN = -30.0f; // Shoulder joint: more realistic min angle
+const float LEFT_UPPER_ARM_MAX = 180.0f;  // Shoulder joint: more realistic max angle
+const float RIGHT_UPPER_ARM_MIN = -30.0f; // Shoulder joint: more realistic min angle
+const float RIGHT_UPPER_ARM_MAX = 180.0f;  // Shoulder joint: more realistic max angle
+
+const float LEFT_LOWER_ARM_MIN = 0.0f;   // Elbow joint: realistic min angle (fully extended)
+const float LEFT_LOWER_ARM_MAX = 150.0f; // Elbow joint: realistic max angle (bent)
+const float RIGHT_LOWER_ARM_MIN = 0.0f;  // Elbow joint: realistic min angle (fully extended)
+const float RIGHT_LOWER_ARM_MAX = 150.0f; // Elbow joint: realistic max angle (bent)
+
+const float LEFT_WRIST_MIN = -30.0f; // Wrist joint: realistic min angle
+const float LEFT_WRIST_MAX = 30.0f;  // Wrist joint: realistic max angle
+const float RIGHT_WRIST_MIN = -30.0f; // Wrist joint: realistic min angle
+const float RIGHT_WRIST_MAX = 30.0f;  // Wrist joint: realistic max angle
+
+// The joints of the robot skeleton, parents before their children
+enum RobotJoint {
+    ROBOT_ROOT, // the position, turned about y by the direction
+    ROBOT_TORSO, // stands the body up: its z axis is up and the face looks along -y
+    ROBOT_RIGHT_HIP, ROBOT_RIGHT_FOOT,
+    ROBOT_LEFT_HIP, ROBOT_LEFT_FOOT,
+    ROBOT_RIGHT_SHOULDER, ROBOT_RIGHT_ELBOW, ROBOT_RIGHT_WRIST,
+    ROBOT_LEFT_SHOULDER, ROBOT_LEFT_ELBOW, ROBOT_LEFT_WRIST,
+    ROBOT_NECK,
+    ROBOT_HEAD_TURN, // the horizontal head angle
+    ROBOT_HEAD_NOD, // the vertical head angle
+    ROBOT_JOINTS
+};
+
+// Points of the robot, in the frame of a joint
+extern const glm::vec3 ROBOT_EYES; // between the eyes, on the face (ROBOT_HEAD_NOD)
+extern const glm::vec3 ROBOT_HEAD_TOP; // ROBOT_HEAD_NOD
+extern const glm::vec3 ROBOT_FINGERTIPS; // the tips of the fingers (the wrists)
+const float ROBOT_LEG_LIFT = 2.5f; // how far a walking step moves a leg along the body
+
+enum RobotShape { ROBOT_CUBE, ROBOT_CYLINDER, ROBOT_SPHERE };
+enum RobotMaterial { ROBOT_METAL, ROBOT_EYE_WHITE, ROBOT_PUPIL, ROBOT_MOUTH, ROBOT_MATERIALS };
+
+// A solid attached to a joint: a unit cube scaled by the transform, or a cylinder (along z from the
+// transform origin) or a sphere of the given size
+struct RobotPart {
+    RobotJoint joint;
+    RobotShape shape;
+    RobotMaterial material;
+    glm::mat4 transform; // from the joint frame
+    float radius, height; // of the cylinders and spheres
+    bool detail; // small enough to leave out far away
+};
+
+struct RobotMaterialColors {
+    float ambient[4], diffuse[4], specular[4], shininess;
+};
+
+extern const RobotMaterialColors ROBOT_MATERIAL_COLORS[ROBOT_MATERIALS];
+
+void buildRobotSkeleton(Skeleton& skeleton); // add the joints of a robot standing at (0, 1, 0), in RobotJoint order
+const vector<RobotPart>& robotParts(); // the solids of the robot, the same for every robot, in material order
@@ -10,8 +10,6 @@ void keyboardcallback(unsigned char key, int x, int y)
     currentInstance->keyboard(key, x, y);
 }
 
-void timercallback(int v) { currentInstance->timer(v); }
-
 // Callback functions
 void mouseButtonCallback(int button, int state, int x, int y) { currentInstance->mouseButton(button, state, x, y); }
 void mouseMotionCallback(int x, int y) { currentInstance->mouseMotion(x, y); }
@@ -92,39 +90,50 @@ void Scene::mouseWheel(int button, int dir, int x, int y) {
     glutPostRedisplay();
 }
 
-void Scene::addBubble() {
-    glm::vec3 pos(10.0f, 2.0f, 4.8f); // Starting position of the bubble
-
-    // Increase horizontal velocity spread and decrease vertical velocity
-    glm::vec3 vel(
-        (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 5.0f, // Increased horizontal spread
-        (static_cast<float>(rand()) / RAND_MAX) * 2.0f + 3.0f, // Reduced initial upward velocity
-        (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 5.0f
-    );
-
-    // Transparent color
-    glm::vec4 col(1.0f, 1.0f, 1.0f, 0.3f); // Transparent
-
-    float life = 10.0f; // Lifespan for bubbles
-    float size = static_cast<float>(rand()) / RAND_MAX * 0.1f + 0.2f; // Random size between 0.3 and 0.4
-
-    GLfloat wallXMin = -12.0f;
-    GLfloat wallXMax = 12.0f;
-    GLfloat wallYMin = -12.0f;
-    GLfloat wallYMax = 12.0f;
-    GLfloat wallHeight = 12.0f;
-
-    bubbles.addParticle(Particle(pos, vel, col, life, size, wallXMin, wallXMax, wallYMin, wallYMax, wallHeight));
+void Scene::addBubblesMachine(const glm::vec3& position) {
+    ObjectGL* machine = new ObjectGL("smokeMachine.obj", position.x, position.y, position.z, 1.2f);
+    this->bubblesMachines.push_back(machine);
+
+    // the bubbles leave the nozzle on top of the machine
+    Emitter emitter;
+    emitter.position = position + glm::vec3(0.0f, 1.0f, 0.0f);
+    emitter.rate = 300.0f; // five bubbles per tick
+    emitter.minVelocity = glm::vec3(-2.5f, 3.0f, -2.5f); // wide horizontal spread, slow upward
+    emitter.maxVelocity = glm::vec3(2.5f, 5.0f, 2.5f);
+    emitter.minLife = emitter.maxLife = 10.0f;
+    emitter.minSize = 0.2f;
+    emitter.maxSize = 0.3f;
+    emitter.color = glm::vec4(1.0f, 1.0f, 1.0f, 0.3f); // Transparent
+    emitter.random = Random::stream("bubbles machine", this->bubblesMachines.size());
+    bubbles.addEmitter(emitter);
 }
 
 Scene::Scene(int argc, char** argv) {
-    // Initialize SDL and play the song
-    if (!initSDL()) {
-        std::cerr << "Failed to initialize SDL for audio" << std::endl;
-        return;
+    // Everything random derives from one seed, printed so a run can be repeated with --seed
+    Random::setSeed(Random::parseSeed(argc, argv));
+    std::cout << "Random seed: " << Random::seed() << std::endl;
+
+    // Start loading the models on the worker threads while the window is created
+    AssetLoader& loader = AssetLoader::instance();
+    const char* models[] = { "alien.obj", "myDesk.obj", "ROBOT-TEX.obj", "dj.obj", "smokeMachine.obj",
+                             "speakers.obj", "spotlight.obj", "roundSpot.obj" };
+    for (const char* model : models) {
+        loader.preloadModel(model);
     }
 
-    startMusic("party.mp3");
+    // Initialize SDL and play the song
+    future<void> audio = loader.runAsync("party.mp3", "audio", []() {
+        if (!initSDL()) {
+            std::cerr << "Failed to initialize SDL for audio" << std::endl;
+            return; // the party goes on without music
+        }
+        startMusic("party.mp3");
+    });
+
+    // Setup Dear ImGui context and build the fonts in the background
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    future<void> fonts = loader.runAsync("fonts", "build", [this]() { loadFonts(); });
 
     // Initialize GLUT
     glutInit(&argc, argv);
@@ -142,6 +151,12 @@ Scene::Scene(int argc, char** argv) {
     glutInitWindowPosition(0, 0);
     glutCreateWindow("Fusturistic party");
 
+    // Load the buffer object functions used by the objects meshes
+    loadGLExtensions();
+
+    // Draw with placeholder textures while the real ones stream in
+    TextureRegistry::instance().setStreaming(true);
+
     // Create drawing objects
     this->floor = new Floor(-12, 12, -12, 12);
     this->walls = new Walls(12, -12, 12, -12, 12);
@@ -153,10 +168,55 @@ Scene::Scene(int argc, char** argv) {
     this->static_robot = new ObjectGL("ROBOT-TEX.obj", 5.4, 2.2, -9.5f, 5.0f);
     this->dj = new ObjectGL("dj.obj", -5.3, 3.9, -5.3, 3.5f);
     this->dj->angle = 33.66;
-    this->bubblesMachine = new ObjectGL("smokeMachine.obj", 10.0, 1, 4.8, 1.2f);
-    this->speakers = new ObjectGL("speakers.obj", -10.4, 0, 4.98, 0.16f);
-    this->speakers->initY = 0;
+    for (const glm::vec3& position : BUBBLES_MACHINES) {
+        addBubblesMachine(position);
+    }
+    this->speakers = new InstancedObjectGL("speakers.obj");
     this->speakers->initY = 0;
+    for (const glm::vec3& position : SPEAKERS) {
+        ObjectInstance speaker;
+        speaker.position = position;
+        speaker.angle = position.x < 0 ? 0.0f : 180.0f; // facing the dance floor
+        speaker.scale = 0.16f;
+        this->speakers->addInstance(speaker);
+    }
+    bubbles.setBounds(glm::vec3(-12.0f, 0.0f, -12.0f), glm::vec3(12.0f, 12.0f, 12.0f)); // the bubbles pop on the walls, floor and ceiling
+
+    // The props that never move are baked into world space and drawn together
+    this->bubbleRenderer = new BubbleRenderer();
+    this->crowdMesh = new RobotMesh(CROWD_MESH_SLICES);
+    this->simulationPool = new ThreadPool(); // separate from the asset loader so the update never waits for a load
+    bubbles.pool = this->simulationPool;
+    this->staticBatch = new StaticBatch();
+    vector<ObjectGL*> staticObjects = { this->desk, this->dj, this->static_robot };
+    staticObjects.insert(staticObjects.end(), this->bubblesMachines.begin(), this->bubblesMachines.end());
+    for (ObjectGL* object : staticObjects) {
+        object->isStatic = true;
+        this->staticBatch->add(object);
+    }
+
+    // The bubbles collide with a distance field of the props, baked once and cached next to the objects
+    // (not the machines they leave from; the speakers only vibrate by a few centimeters)
+    this->sceneField = new DistanceField(glm::vec3(-12.0f, 0.0f, -12.0f), glm::vec3(12.0f, 12.0f, 12.0f));
+    ObjectGL* fieldObjects[] = { this->desk, this->dj, this->static_robot, this->speakers };
+    for (ObjectGL* object : fieldObjects) {
+        this->sceneField->addObject(*object);
+    }
+    this->sceneField->addPlane(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)); // the floor
+    if (walls->showSouth) {
+        this->sceneField->addPlane(glm::vec3(0.0f, 0.0f, walls->yMin), glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    if (walls->showNorth) {
+        this->sceneField->addPlane(glm::vec3(0.0f, 0.0f, walls->yMax), glm::vec3(0.0f, 0.0f, -1.0f));
+    }
+    if (walls->showWest) {
+        this->sceneField->addPlane(glm::vec3(walls->xMin, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+    if (walls->showEast) {
+        this->sceneField->addPlane(glm::vec3(walls->xMax, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f));
+    }
+    this->sceneField->build(GetObjectDir(this->desk->inputfile) + "club" + DISTANCE_FIELD_EXTENSION);
+    bubbles.field = this->sceneField->particleField(PARTICLE_COLLIDE_POP, 0.5f);
     // rectSpotlight setup
     this->rectSpotlight = new Light(GL_LIGHT0, 10.763, 10.5, -10.482, "spotlight.obj", 2.7f);
     this->rectSpotlight->target[0] = -6; // Update target position
@@ -173,16 +233,18 @@ Scene::Scene(int argc, char** argv) {
     this->roundSpotlight->exponent = 1.22; // Set rotation angle for the roundSpotlight's object representation
     this->roundSpotlight->cutoff = 71.7; // Set rotation angle for the roundSpotlight's object representation
 
+    // Report how long the meshes took to load (cached vs imported) and how the textures were shared
+    printMeshLoadReport();
+    TextureRegistry::instance().printStats();
+
     robot = Robot();
     speakers->setVibration(vibratingSpeakers, speakers->PosY);
     alien->setVibration(vibratingAlien, alien->PosY);
+    speakersY.set(speakers->PosY);
+    alienY.set(alien->PosY);
 
-    // Setup Dear ImGui context
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-
-    // Load fonts
-    loadFonts();
+    // Wait for the fonts
+    fonts.wait();
 
     // Setup Dear ImGui style
     ImGui::StyleColorsClassic();
@@ -196,26 +258,63 @@ Scene::Scene(int argc, char** argv) {
     ::currentInstance = this;
     glutReshapeFunc(reshapecallback);
     glutDisplayFunc(displaycallback);
-    glutTimerFunc(100, timercallback, 0);
     glutKeyboardFunc(keyboardcallback);
     glutMouseFunc(mouseButtonCallback);
     glutMotionFunc(mouseMotionCallback);
     glutMouseWheelFunc(mouseWheelCallback);
 
-    // Initialize random seed for smoke particles
-    srand(static_cast<unsigned int>(time(0)));
-
     glutMainLoop(); // Run the main loop
 
     // ImGui cleanup
     ImGui_ImplOpenGL2_Shutdown();
     ImGui_ImplGLUT_Shutdown();
     ImGui::DestroyContext();
+    audio.wait();
     cleanUpSDL();
 
 }
 
 void Scene::display() {
+    FrameProfiler::instance().beginFrame();
+
+    // Slow the bubbles machines down when the bubbles took too long
+    FrameProfiler& profiler = FrameProfiler::instance();
+    bubbles.budget.govern(profiler.lastMs("bubbles update") + profiler.lastMs("bubbles draw"));
+
+    // Run the simulation ticks that are due, from the simulated state (not the drawn one)
+    int ticks = clock.advance();
+    if (ticks > 0) {
+        speakers->PosY = speakersY.current;
+        alien->PosY = alienY.current;
+    }
+    for (int i = 0; i < ticks; i++) {
+        clock.step();
+        tick((float)SIMULATION_TICK);
+    }
+
+    // Draw between the last two ticks
+    float alpha = clock.alpha();
+    speakers->PosY = speakersY.at(alpha);
+    alien->PosY = alienY.at(alpha);
+    if (dancingRobot) {
+        robot.dance(40 * (float)clock.renderTime()); // a pose for any time, no state to interpolate
+    }
+    if (crowdMode) {
+        ProfileScope scope("crowd animate");
+        if (crowd.size() != (size_t)crowdSize) {
+            crowd.populate(crowdSize, glm::vec2(-11.0f), glm::vec2(11.0f));
+        }
+        crowd.animate(40 * (float)clock.renderTime(), bubbles.kernel);
+        crowd.pose(simulationPool);
+    }
+
+    // Upload the textures that finished loading
+    TextureRegistry::instance().update();
+
+    // Keep the culling counters of the last frame for the debug window
+    lastCullStats = ObjectGL::cullStats;
+    ObjectGL::cullStats = CullStats();
+
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL2_NewFrame();
     ImGui_ImplGLUT_NewFrame();
@@ -223,6 +322,8 @@ void Scene::display() {
     // display the menu with imgui
     if (show_menu)
         display_menu();
+    if (debug_mode)
+        display_debug_overlay();
 
     // Rendering menu
     ImGui::Render();
@@ -231,6 +332,7 @@ void Scene::display() {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     gluPerspective(60.0, aspect, 1, 100.0); // use Perspective projection
+    glm::vec3 eye, target; // the camera, for the bubbles facing it
     if (robot_view) {
         // Get the eye and center positions from the robot
         glm::vec3 viewPos = robot.getViewPos();  // Get the view position (eye and center)
@@ -245,12 +347,16 @@ void Scene::display() {
 
         // Set the camera using gluLookAt
         gluLookAt(eyeX, eyeY, eyeZ, centerX, centerY, centerZ, 0.0f, 1.0f, 0.0f);
+        eye = glm::vec3(eyeX, eyeY, eyeZ);
+        target = glm::vec3(centerX, centerY, centerZ);
     }
     else {
         // Regular view mode
         gluLookAt(camera_position[0], camera_position[1], camera_position[2],
             camera_target[0], camera_target[1], camera_target[2],
             0, 1, 0);
+        eye = glm::vec3(camera_position[0], camera_position[1], camera_position[2]);
+        target = glm::vec3(camera_target[0], camera_target[1], camera_target[2]);
     }
 
 
@@ -275,15 +381,34 @@ void Scene::display() {
 
     // start drawing
     floor->draw();
+    staticBatch->update();
+    staticBatch->draw();
     alien->draw();
     static_robot->draw();
     dj->draw();
     desk->draw();
     speakers->draw();
-    bubblesMachine->draw();
+    for (ObjectGL* machine : bubblesMachines) {
+        machine->draw();
+    }
     rectSpotlight->draw();
     roundSpotlight->draw();
-    robot.draw();
+
+    // skip the robot when its bounding sphere is out of the view
+    glm::vec3 robotCenter;
+    float robotRadius;
+    robot.getBounds(robotCenter, robotRadius);
+    if (!ObjectGL::cullingEnabled || Frustum::current().containsSphere(robotCenter, robotRadius)) {
+        robot.draw();
+        ObjectGL::cullStats.objectsDrawn++;
+    }
+    else {
+        ObjectGL::cullStats.objectsCulled++;
+    }
+    if (crowdMode) {
+        ProfileScope scope("crowd draw");
+        crowdMesh->drawCrowd(crowd, eye);
+    }
 
     // enable blending for walls transparency
     glEnable(GL_BLEND);
@@ -291,13 +416,10 @@ void Scene::display() {
     walls->draw();
     glDisable(GL_BLEND);
 
-    // Conditionally update and draw the smoke system (bubbles)
+    // Conditionally draw the smoke system (bubbles)
     if (enableBubbles) {
-        for (int i = 0; i < 5; ++i) {
-            addBubble();
-        }
-        bubbles.update(0.1f); // Assuming 60 FPS, delta time is 1/60
-        bubbles.draw();
+        ProfileScope scope("bubbles draw"); // includes the depth sort
+        bubbleRenderer->draw(bubbles, eye, target, clock.lag());
     }
 
     // add Coordinate Arrows for debug
@@ -309,31 +431,29 @@ void Scene::display() {
 
     glFlush();
     glutSwapBuffers();
+    AssetLoader::instance().firstFrame(); // log the startup timeline once
     glutPostRedisplay();
 }
 
-void Scene::timer(int v) {
-
-    bubbles.update(0.016f); // Assuming 60 FPS, delta time is 1/60
+void Scene::tick(float dt) {
+    // the bubbles machines blow the same number of bubbles every second, within the budget
+    if (enableBubbles) {
+        ProfileScope scope("bubbles update");
+        bubbles.update(dt);
+    }
 
     // Apply vibration to the selected objects
-    static float time = 0.0f;
-    time += 0.016f; // Increment time by the frame duration
-
+    float time = (float)clock.time();
     if (vibratingSpeakers) {
         speakers->vibrate(0.1f, 5.0f, 5*time,speakers->PosY);
     }
-
     if (vibratingAlien) {
         alien->vibrate(0.4f, 2.0f, 5*time, alien->PosY);
     }
-  
-    if (dancingRobot) {
-        robot.dance(40*time);
-    }
+    speakersY.tick(speakers->PosY);
+    alienY.tick(alien->PosY);
 
-
-    glutTimerFunc(100 / 60, timercallback, v); // recursively call itself for the next frame
+    rectSpotlight->tick();
 }
 
 // in keyboard function
@@ -510,6 +630,133 @@ void Scene::drawCoordinateArrows(void) {
     glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, 'z');
 }
 
+void Scene::display_debug_overlay() {
+    struct NamedObject {
+        const char* name;
+        ObjectGL* object;
+    };
+    vector<NamedObject> objects = {
+        { "alien", alien }, { "desk", desk }, { "static robot", static_robot }, { "dj", dj },
+        { "speakers", speakers }, { "rect spotlight", rectSpotlight->object }, { "round spotlight", roundSpotlight->object }
+    };
+    for (ObjectGL* machine : bubblesMachines) {
+        objects.push_back({ "bubbles machine", machine });
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Once);
+    ImGui::Begin("Level of detail", &debug_mode, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Checkbox("enable LOD", &ObjectGL::lodEnabled); HelpMarker("draw simplified meshes of objects that are small on screen");
+    ImGui::Separator();
+
+    // the triangles of the last frame, against drawing every object at full detail
+    GLsizei drawnTotal = 0, fullTotal = 0;
+    for (const NamedObject& named : objects) {
+        if (named.object == NULL) {
+            continue;
+        }
+        GLsizei full = named.object->triangleCount(0);
+        if (named.object == speakers) {
+            // every copy picks its own level
+            int lowest, highest;
+            speakers->lodRange(lowest, highest);
+            full *= (GLsizei)speakers->instanceCount(); // every copy at full detail
+            ImGui::Text("%-16s LOD %d-%d %7d / %7d triangles", named.name, lowest, highest, named.object->trianglesDrawn, full);
+        }
+        else {
+            ImGui::Text("%-16s LOD %d  %7d / %7d triangles", named.name, named.object->lodLevel, named.object->trianglesDrawn, full);
+        }
+        drawnTotal += named.object->trianglesDrawn;
+        fullTotal += full;
+    }
+    ImGui::Separator();
+    ImGui::Text("triangles saved: %d (%.1f%%)", fullTotal - drawnTotal, fullTotal > 0 ? 100.0f * (fullTotal - drawnTotal) / fullTotal : 0.0f);
+
+    // the objects and shapes skipped by the view frustum in the last frame
+    ImGui::Separator();
+    ImGui::Checkbox("enable culling", &ObjectGL::cullingEnabled); HelpMarker("skip the objects and shapes outside the view");
+    ImGui::Text("objects drawn %3d  culled %3d", lastCullStats.objectsDrawn, lastCullStats.objectsCulled);
+    ImGui::Text("shapes  drawn %3d  culled %3d", lastCullStats.shapesDrawn, lastCullStats.shapesCulled);
+    ImGui::Text("speakers drawn %d of %zu copies", speakers->instancesDrawn, speakers->instanceCount());
+
+    // the props merged by material
+    ImGui::Separator();
+    ImGui::Checkbox("static batching", &ObjectGL::staticBatching); HelpMarker("draw the props that never move from buffers merged by material");
+    ImGui::Text("%d material buckets, %d bakes", (int)staticBatch->bucketCount(), staticBatch->bakes);
+
+    // the bubbles pool, to size it for long runs
+    ImGui::Separator();
+    ImGui::Text("bubbles live %zu  peak %zu  capacity %zu", bubbles.count(), bubbles.peak, bubbles.capacity());
+    ImGui::Text("dropped %zu  refused %zu", bubbles.dropped, bubbles.refused);
+    int mode = bubbleRenderer->mode;
+    const char* modes[] = { "spheres", "impostors", "point sprites" };
+    if (ImGui::Combo("bubbles drawn as", &mode, modes, 3)) {
+        bubbleRenderer->mode = (BubbleRenderMode)mode;
+    }
+    if (bubbleRenderer->drawnMode() != bubbleRenderer->mode) {
+        ImGui::Text("point sprites are not supported, drawing impostors");
+    }
+    int overflow = bubbles.overflow;
+    const char* policies[] = { "drop oldest", "refuse spawn" };
+    if (ImGui::Combo("when full", &overflow, policies, 2)) {
+        bubbles.overflow = (ParticleOverflow)overflow;
+    }
+    static int capacity = (int)bubbles.capacity();
+    ImGui::InputInt("capacity", &capacity, 256, 4096);
+    if (capacity != (int)bubbles.capacity() && capacity > 0 && ImGui::Button("resize pool (clears the bubbles)")) {
+        bubbles.setCapacity(capacity);
+        bubbles.peak = 0;
+    }
+
+    // the bubbles touching the props and walls, sampled from the distance field
+    int collision = bubbles.field.response;
+    const char* collisions[] = { "pass through", "pop", "bounce" };
+    if (ImGui::Combo("when bubbles hit the scene", &collision, collisions, 3)) {
+        bubbles.field.response = (ParticleCollision)collision;
+    }
+    if (bubbles.field.response == PARTICLE_COLLIDE_BOUNCE) {
+        ImGui::SliderFloat("bounce restitution", &bubbles.field.restitution, 0.0f, 1.0f);
+    }
+    ImGui::Text("distance field of %zu triangles, %s in %.0f ms", sceneField->triangleCount(), sceneField->fromCache ? "loaded" : "baked", sceneField->buildMs);
+
+    // the bubbles touching each other, found with the grid
+    int contact = bubbles.contact;
+    const char* contacts[] = { "pass through", "merge", "pop" };
+    if (ImGui::Combo("when bubbles touch", &contact, contacts, 3)) {
+        bubbles.contact = (ParticleContact)contact;
+    }
+    ImGui::Text("merged %zu  popped %zu", bubbles.merged, bubbles.popped);
+
+    // the spawn rate kept within the frame budget
+    ImGui::SliderFloat("bubbles budget ms", &bubbles.budget.targetMs, 0.0f, 8.0f); HelpMarker("slow the bubbles machines down when the bubbles take longer than this per frame (0 for no limit)");
+    ImGui::Text("%d machines blowing at %.0f%% of their rate", (int)bubbles.emitters.size(), 100.0f * bubbles.budget.scale);
+
+    // the bubbles are blended from back to front
+    ImGui::Checkbox("sort bubbles by depth", &bubbleRenderer->sortByDepth); HelpMarker("draw the farthest bubbles first so they blend right where they overlap");
+    if (bubbleRenderer->sortByDepth) {
+        const DepthSortStats& sort = bubbleRenderer->depthSort.stats;
+        const char* paths[] = { "already sorted", "insertion", "radix" };
+        ImGui::Text("sort: %s, %zu out of order, %d radix passes, %.3f ms", paths[sort.path], sort.outOfOrder, sort.radixPasses, sort.ms);
+    }
+
+    // the crowd, drawn piece by piece for all the robots
+    if (crowdMode) {
+        ImGui::Separator();
+        ImGui::Text("crowd of %zu robots: %d drawn (%d in detail), %d culled", crowd.size(), crowdMesh->robotsDrawn, crowdMesh->robotsDetailed, crowdMesh->robotsCulled);
+        ImGui::Text("%d draw calls, %zu vertices per robot, %s kernel", crowdMesh->drawCalls, crowdMesh->vertexCount(), particleKernelName(bubbles.kernel));
+    }
+
+    // where the frame time goes
+    ImGui::Separator();
+    ImGui::Text("%-16s %8s %8s", "section", "last ms", "avg ms");
+    for (const auto& section : FrameProfiler::instance().sections()) {
+        ImGui::Text("%-16s %8.3f %8.3f", section.first.c_str(), section.second.lastMs, section.second.averageMs);
+    }
+    ImGui::Text("simulation %.0f Hz: %d ticks this frame, %llu skipped", 1.0 / SIMULATION_TICK, clock.lastTicks, (unsigned long long)clock.skipped);
+    ImGui::Text("robot joint matrices recomputed: %zu", robot.jointsRecomputed());
+    ImGui::Text("random seed %llu (--seed to repeat the run)", (unsigned long long)Random::seed());
+    ImGui::End();
+}
+
 void Scene::display_menu() {
     ImGuiIO& io = ImGui::GetIO();
     ImFont* font1 = io.Fonts->Fonts[1];
@@ -530,7 +777,7 @@ void Scene::display_menu() {
     ImGui::PushFont(font1); // Set font1 as the default font for all ImGui elements
 
     ImGui::Begin("Menu", &show_menu);
-    //ImGui::Checkbox("debug mode", &debug_mode); HelpMarker("mark to enter debug mode");
+    ImGui::Checkbox("debug mode", &debug_mode); HelpMarker("mark to enter debug mode");
     // Add a checkbox to toggle full screen mode
     static bool fullScreenChecked = fullScreen;
 
@@ -611,6 +858,10 @@ void Scene::display_menu() {
         ImGui::Checkbox("control Vibrating Speakers", &vibratingSpeakers);
         ImGui::Checkbox("control jumping alien", &vibratingAlien);
         ImGui::Checkbox("dancing Robot", &dancingRobot);
+        ImGui::Checkbox("robot crowd", &crowdMode); HelpMarker("fill the floor with robots dancing out of step");
+        if (crowdMode) {
+            ImGui::SliderInt("crowd robots", &crowdSize, 1, 10000);
+        }
         ImGui::Checkbox("control Bubbles", &enableBubbles);
 
         // Enable vibration for the selected objects
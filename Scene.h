@@ -13,12 +13,23 @@
 using namespace std;
 
 #include "ObjectGL.h"
+#include "StaticBatch.h"
+#include "InstancedObjectGL.h"
 #include "Floor.h"
 #include "Light.h"
 #include "Walls.h"
 #include "ParticleSystem.h"
+#include "ThreadPool.h"
+#include "BubbleRenderer.h"
+#include "DistanceField.h"
 #include "Robot.h"
+#include "RobotCrowd.h"
+#include "RobotMesh.h"
 #include "Music.h"
+#include "AssetLoader.h"
+#include "FrameProfiler.h"
+#include "SimulationClock.h"
+#include "Random.h"
 #define M_PI 3.14159265358979323846
 
 // Window settings
@@ -43,6 +54,8 @@ static int le = 0;                       // Round spotlight enabled (0) or disab
 static bool vibratingSpeakers = true;    // Toggle for vibrating speakers
 static bool vibratingAlien = true;       // Toggle for vibrating alien
 static bool dancingRobot = false;        // Toggle for dancing robot
+static bool crowdMode = false;           // Toggle for the crowd of dancing robots
+static int crowdSize = 5000;             // Robots in the crowd
 static bool enableBubbles = true;        // Toggle for enabling bubbles (default is enabled)
 
 // Miscellaneous settings
@@ -50,6 +63,10 @@ static bool debug_mode = false;          // Toggle for debug mode (shows additio
 static bool show_menu = true;            // Toggle for displaying the ImGui menu
 static bool robot_view = false;          // Toggle for robot's point of view
 
+// Where the bubbles machines stand
+static const glm::vec3 BUBBLES_MACHINES[] = { glm::vec3(10.0f, 1.0f, 4.8f), glm::vec3(-10.0f, 1.0f, -1.0f) };
+static const glm::vec3 SPEAKERS[] = { glm::vec3(-10.4f, 0.0f, 4.98f), glm::vec3(-10.4f, 0.0f, -4.5f), glm::vec3(10.4f, 0.0f, -1.5f), glm::vec3(10.4f, 0.0f, 9.0f) };
+
 // ImGui helper function to show tooltips
 static void HelpMarker(const char* desc) {
     ImGui::TextDisabled("(?)");
@@ -68,18 +85,27 @@ class Scene
 private:
     // Scene objects
     Robot robot;                  // Main robot object
+    RobotCrowd crowd;             // Robots dancing all over the floor in crowd mode
+    RobotMesh* crowdMesh;         // Draws the crowd
     ObjectGL* desk;               // Desk object
-    ObjectGL* speakers;           // Speakers object
+    InstancedObjectGL* speakers;  // The speakers around the dance floor, copies of one model
     ObjectGL* dj;                 // DJ object
     ObjectGL* alien;              // Alien object
     ObjectGL* static_robot;       // Static robot object
-    ObjectGL* bubblesMachine;     // Bubbles machine object
+    vector<ObjectGL*> bubblesMachines; // Bubbles machine objects, each blowing into the bubbles
     ObjectGL* chair;              // Chair object
     Light* rectSpotlight;         // Rectangular spotlight object
     Light* roundSpotlight;        // Round spotlight object
     Floor* floor;                 // Floor object
     Walls* walls;                 // Walls object
     ParticleSystem bubbles;   // Particle system for smoke
+    BubbleRenderer* bubbleRenderer; // Draws the bubbles
+    ThreadPool* simulationPool;   // Workers sharing the particle update
+    StaticBatch* staticBatch;     // The props that never move, merged by material
+    DistanceField* sceneField;    // The props and walls the bubbles collide with
+    SimulationClock clock;        // Fixed ticks of the simulation
+    TickedFloat speakersY;        // Simulated height of the vibrating speakers
+    TickedFloat alienY;           // Simulated height of the jumping alien
 
     // Interaction state
     bool dragging = false;        // State for mouse dragging
@@ -88,13 +114,16 @@ private:
     float cameraSpeed = 0.1f;     // Speed of the camera movement
     bool fullScreen = false;      // Full-screen toggle state
     int windowedX, windowedY, windowedWidth, windowedHeight; // Store windowed mode settings
+    CullStats lastCullStats;      // Objects drawn and culled in the last frame
 
     // Helper methods
     void drawRobot();             // Method to draw the robot
     void drawCoordinateArrows();  // Method to draw coordinate arrows for debugging
     static Scene* currentInstance; // Static instance to allow OpenGL callbacks in class
     void display_menu();          // Method to display the ImGui menu
-    void addBubble();      // Method to add a smoke particle
+    void display_debug_overlay(); // Method to display the debug statistics window
+    void addBubblesMachine(const glm::vec3& position); // Method to add a bubbles machine and its emitter
+    void tick(float dt);          // Method to advance the simulation by one fixed tick
 
 public:
     // Constructor
@@ -107,7 +136,6 @@ public:
     void reshape(GLint w, GLint h); // Method to handle window resizing
     void SpecialInput(int key, int x, int y); // Method to handle special key (arrow) press events
     void SpecialInputUp(int key, int x, int y); // Method to handle special key release events
-    void timer(int v);            // Method that is called every time interval
     void mouseButton(int button, int state, int x, int y); // Method to handle mouse button events
     void mouseMotion(int x, int y); // Method to handle mouse motion events
     void mouseWheel(int button, int dir, int x, int y); // Method to handle mouse wheel events
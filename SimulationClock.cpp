@@ -0,0 +1,30 @@
+#include "SimulationClock.h"
+#include <chrono>
+
+static double seconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SimulationClock::SimulationClock() {
+    this->last = seconds();
+}
+
+int SimulationClock::advance() {
+    double now = seconds();
+    this->accumulator += now - this->last;
+    this->last = now;
+
+    int due = (int)(this->accumulator / SIMULATION_TICK);
+    this->accumulator -= due * SIMULATION_TICK;
+    if (due > SIMULATION_MAX_TICKS) {
+        // after a stall (loading, a dragged window) catching up would only make the next frame later
+        this->skipped += due - SIMULATION_MAX_TICKS;
+        due = SIMULATION_MAX_TICKS;
+    }
+    this->lastTicks = due;
+    return due;
+}
+
+float SimulationClock::alpha() const {
+    return (float)(this->accumulator / SIMULATION_TICK);
+}
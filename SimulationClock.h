@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+using namespace std;
+
+const double SIMULATION_TICK = 1.0 / 60.0; // seconds simulated by one tick
+const int SIMULATION_MAX_TICKS = 8; // ticks run in one frame at most, the rest of a long stall is skipped
+
+// Turns the real time between frames into fixed simulation ticks.
+// Every frame runs the ticks that are due, then draws between the last two ticks at alpha(), so the
+// scene moves the same at any frame rate and the simulation costs the same every second.
+class SimulationClock {
+public:
+    SimulationClock();
+
+    int advance(); // add the real time since the last call, returns the number of ticks to run now
+    void step() { this->ticks++; } // start one of those ticks
+
+    double time() const { return this->ticks * SIMULATION_TICK; } // the simulation time of the last tick, in seconds
+    float alpha() const; // how far the frame is from the tick before the last one to the last one, 0 to 1
+    float lag() const { return (float)((1.0 - alpha()) * SIMULATION_TICK); } // seconds the frame is behind the last tick
+    double renderTime() const { return time() - lag(); } // the simulation time of the frame
+
+    uint64_t ticks = 0; // ticks run since the start
+    uint64_t skipped = 0; // ticks dropped after stalls
+    int lastTicks = 0; // ticks run in the last frame
+
+private:
+    double last; // the real time of the last call, in seconds
+    double accumulator = 0; // real time not simulated yet, in seconds
+};
+
+// a simulated value at the last two ticks, drawn in between
+struct TickedFloat {
+    float previous = 0;
+    float current = 0;
+
+    void set(float value) { this->previous = this->current = value; } // jump, nothing to interpolate
+    void tick(float value) { this->previous = this->current; this->current = value; }
+    float at(float alpha) const { return this->previous + (this->current - this->previous) * alpha; }
+};
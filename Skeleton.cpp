@@ -0,0 +1,49 @@
+#include "Skeleton.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+int Skeleton::addJoint(int parent, const glm::vec3& offset, const glm::vec3& axis, float angle, float minAngle, float maxAngle) {
+    Joint joint = { parent, offset, axis, min(max(angle, minAngle), maxAngle), minAngle, maxAngle };
+    this->joints.push_back(joint);
+    this->worlds.push_back(glm::mat4(1.0f));
+    this->dirty.push_back(1);
+    return (int)this->joints.size() - 1;
+}
+
+void Skeleton::setAngle(int joint, float angle) {
+    Joint& j = this->joints[joint];
+    angle = min(max(angle, j.minAngle), j.maxAngle);
+    if (angle != j.angle) {
+        j.angle = angle;
+        this->dirty[joint] = 1;
+    }
+}
+
+void Skeleton::setOffset(int joint, const glm::vec3& offset) {
+    Joint& j = this->joints[joint];
+    if (offset != j.offset) {
+        j.offset = offset;
+        this->dirty[joint] = 1;
+    }
+}
+
+void Skeleton::update() {
+    // the parents come first, so a dirty parent has marked its children by the time they are reached
+    bool any = false;
+    for (size_t i = 0; i < this->joints.size(); i++) {
+        const Joint& joint = this->joints[i];
+        if (joint.parent >= 0 && this->dirty[joint.parent]) {
+            this->dirty[i] = 1;
+        }
+        if (!this->dirty[i]) {
+            continue;
+        }
+        glm::mat4 local = glm::rotate(glm::translate(glm::mat4(1.0f), joint.offset), glm::radians(joint.angle), joint.axis);
+        this->worlds[i] = joint.parent >= 0 ? this->worlds[joint.parent] * local : local;
+        this->recomputed++;
+        any = true;
+    }
+    if (any) {
+        fill(this->dirty.begin(), this->dirty.end(), 0);
+    }
+}
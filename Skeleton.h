@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <vector>
+
+using namespace std;
+
+// A joint of a skeleton: a rotation about one axis, at an offset from its parent's frame.
+struct Joint {
+    int parent; // -1 for a root, otherwise an earlier joint
+    glm::vec3 offset; // the translation from the parent's frame
+    glm::vec3 axis; // the rotation axis
+    float angle; // degrees
+    float minAngle, maxAngle; // the limits of the angle
+};
+
+// A hierarchy of joints in a flat array, parents before their children, with the world matrix of every
+// joint cached. Changing a joint only marks it dirty; update() recomputes the matrices of the dirty joints
+// and their descendants in one pass over the array, so a skeleton that did not move costs nothing.
+class Skeleton {
+public:
+    int addJoint(int parent, const glm::vec3& offset, const glm::vec3& axis, float angle = 0.0f,
+        float minAngle = -FLT_MAX, float maxAngle = FLT_MAX); // the index of the new joint
+    void setAngle(int joint, float angle); // clamped to the limits of the joint
+    void rotate(int joint, float delta) { setAngle(joint, this->joints[joint].angle + delta); }
+    void setOffset(int joint, const glm::vec3& offset);
+    float angle(int joint) const { return this->joints[joint].angle; }
+    const glm::vec3& offset(int joint) const { return this->joints[joint].offset; }
+    const Joint& joint(int index) const { return this->joints[index]; }
+
+    void update(); // recompute the world matrices of the dirty joints and their descendants
+    const glm::mat4& world(int joint) const { return this->worlds[joint]; } // as of the last update
+    glm::vec3 worldPoint(int joint, const glm::vec3& point) const { return glm::vec3(this->worlds[joint] * glm::vec4(point, 1.0f)); }
+    glm::vec3 worldDirection(int joint, const glm::vec3& direction) const { return glm::vec3(this->worlds[joint] * glm::vec4(direction, 0.0f)); }
+    size_t size() const { return this->joints.size(); }
+    size_t recomputed = 0; // the world matrices recomputed since the skeleton was made
+
+private:
+    vector<Joint> joints;
+    vector<glm::mat4> worlds;
+    vector<char> dirty;
+};
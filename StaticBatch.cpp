@@ -0,0 +1,212 @@
+#include "StaticBatch.h"
+#include <cstring>
+#include <glm/gtc/matrix_inverse.hpp>
+
+StaticBatch::~StaticBatch() {
+    for (Bucket& bucket : this->buckets) {
+        if (bucket.vertexBuffer != 0) {
+            pglDeleteBuffers(1, &bucket.vertexBuffer);
+            pglDeleteBuffers(1, &bucket.indexBuffer);
+        }
+    }
+}
+
+bool StaticBatch::add(ObjectGL* object) {
+    if (!object->isStatic || !object->callbacks.empty()) {
+        return false; // callbacks may change any state, so the object has to draw itself
+    }
+    Entry entry = { object, placementOf(*object) };
+    markBuckets(entry);
+    this->entries.push_back(entry);
+    object->batched = true;
+    return true;
+}
+
+vector<StaticBatch::ShapePlacement> StaticBatch::placementOf(const ObjectGL& object) {
+    glm::mat4 global;
+    int objectMaterial = -1;
+    bool objectVisible = object.shapeTransform(0, global, objectMaterial);
+    glm::mat4 model = object.modelMatrix() * global;
+
+    vector<ShapePlacement> shapes(object.mesh->shapes.size());
+    for (size_t s = 0; s < shapes.size(); s++) {
+        glm::mat4 local;
+        shapes[s].materialOverride = objectMaterial;
+        shapes[s].visible = object.shapeTransform(s + 1, local, shapes[s].materialOverride) && objectVisible;
+        shapes[s].world = model * local;
+    }
+    return shapes;
+}
+
+bool StaticBatch::samePlacement(const vector<ShapePlacement>& a, const vector<ShapePlacement>& b) {
+    for (size_t s = 0; s < a.size(); s++) {
+        if (a[s].visible != b[s].visible || a[s].materialOverride != b[s].materialOverride ||
+            memcmp(&a[s].world, &b[s].world, sizeof(glm::mat4)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const MeshMaterial& StaticBatch::materialOf(const ObjectGL& object, const DrawRange& range, int materialOverride) {
+    return materialOverride >= 0 ? object.materialOverrides[materialOverride] : range.material;
+}
+
+int StaticBatch::findBucket(const MeshMaterial& material, bool create) {
+    for (size_t b = 0; b < this->buckets.size(); b++) {
+        if (memcmp(&this->buckets[b].material, &material, sizeof(MeshMaterial)) == 0) {
+            return (int)b;
+        }
+    }
+    if (!create) {
+        return -1;
+    }
+    this->buckets.push_back(Bucket());
+    this->buckets.back().material = material;
+    return (int)this->buckets.size() - 1;
+}
+
+void StaticBatch::markBuckets(const Entry& entry) {
+    const vector<MeshShape>& shapes = entry.object->mesh->shapes;
+    for (size_t s = 0; s < shapes.size(); s++) {
+        if (!entry.shapes[s].visible) {
+            continue;
+        }
+        for (const DrawRange& range : shapes[s].ranges) {
+            this->buckets[findBucket(materialOf(*entry.object, range, entry.shapes[s].materialOverride), true)].dirty = true;
+        }
+    }
+}
+
+void StaticBatch::update() {
+    for (Entry& entry : this->entries) {
+        vector<ShapePlacement> placement = placementOf(*entry.object);
+        if (!samePlacement(entry.shapes, placement)) {
+            markBuckets(entry); // the buckets the object leaves
+            entry.shapes = placement;
+            markBuckets(entry); // and the ones it goes into
+        }
+    }
+    for (Bucket& bucket : this->buckets) {
+        if (bucket.dirty) {
+            bake(bucket);
+            this->bakes++;
+        }
+    }
+}
+
+void StaticBatch::bake(Bucket& bucket) {
+    bucket.vertices.clear();
+    bucket.indices.clear();
+    glm::vec3 lower(numeric_limits<float>::max()), upper(-numeric_limits<float>::max());
+
+    for (const Entry& entry : this->entries) {
+        const MeshData& mesh = *entry.object->mesh;
+        vector<GLuint> remap(mesh.vertexCount, numeric_limits<GLuint>::max()); // the bucket vertex of each mesh vertex
+        for (size_t s = 0; s < mesh.shapes.size(); s++) {
+            const ShapePlacement& placement = entry.shapes[s];
+            if (!placement.visible) {
+                continue;
+            }
+            glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(placement.world));
+            for (const DrawRange& range : mesh.shapes[s].ranges) {
+                const MeshMaterial& material = materialOf(*entry.object, range, placement.materialOverride);
+                if (memcmp(&material, &bucket.material, sizeof(MeshMaterial)) != 0) {
+                    continue;
+                }
+
+                // copy the full detail triangles, transforming every vertex once per range
+                const IndexSpan& span = range.lods[0];
+                for (GLsizei i = 0; i < span.indexCount; i++) {
+                    GLuint index = mesh.indices[span.firstIndex + i];
+                    if (remap[index] == numeric_limits<GLuint>::max()) {
+                        MeshVertex vertex = mesh.vertices[index];
+                        glm::vec3 position = glm::vec3(placement.world * glm::vec4(glm::make_vec3(vertex.position), 1.0f));
+                        glm::vec3 normal = normalMatrix * glm::make_vec3(vertex.normal);
+                        memcpy(vertex.position, glm::value_ptr(position), sizeof(vertex.position));
+                        memcpy(vertex.normal, glm::value_ptr(normal), sizeof(vertex.normal));
+                        lower = glm::min(lower, position);
+                        upper = glm::max(upper, position);
+                        remap[index] = (GLuint)bucket.vertices.size();
+                        bucket.vertices.push_back(vertex);
+                    }
+                    bucket.indices.push_back(remap[index]);
+                }
+                // the next range may be in another shape with another transform
+                for (GLsizei i = 0; i < span.indexCount; i++) {
+                    remap[mesh.indices[span.firstIndex + i]] = numeric_limits<GLuint>::max();
+                }
+            }
+        }
+    }
+
+    // a sphere around the box is enough for culling
+    glm::vec3 center = (lower + upper) * 0.5f;
+    float radius = bucket.vertices.empty() ? 0.0f : glm::length(upper - center);
+    if (bucket.vertices.empty()) {
+        lower = upper = center = glm::vec3(0);
+    }
+    MeshBounds bounds = {
+        { lower.x, lower.y, lower.z },
+        { upper.x, upper.y, upper.z },
+        { center.x, center.y, center.z },
+        radius
+    };
+    bucket.bounds = bounds;
+
+    if (hasBufferObjects() && !bucket.indices.empty()) {
+        if (bucket.vertexBuffer == 0) {
+            pglGenBuffers(1, &bucket.vertexBuffer);
+            pglGenBuffers(1, &bucket.indexBuffer);
+        }
+        pglBindBuffer(GL_ARRAY_BUFFER, bucket.vertexBuffer);
+        pglBufferData(GL_ARRAY_BUFFER, bucket.vertices.size() * sizeof(MeshVertex), bucket.vertices.data(), GL_STATIC_DRAW);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bucket.indexBuffer);
+        pglBufferData(GL_ELEMENT_ARRAY_BUFFER, bucket.indices.size() * sizeof(GLuint), bucket.indices.data(), GL_STATIC_DRAW);
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    bucket.dirty = false;
+}
+
+void StaticBatch::draw() {
+    if (!ObjectGL::staticBatching) {
+        return;
+    }
+    Frustum frustum = Frustum::current(); // the buckets are in world space
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    for (const Bucket& bucket : this->buckets) {
+        if (bucket.indices.empty() || (ObjectGL::cullingEnabled && !frustum.contains(bucket.bounds))) {
+            continue;
+        }
+        const char* base = NULL; // offsets are relative to the bound buffer
+        const GLvoid* indices = bufferOffset(0);
+        if (bucket.vertexBuffer != 0) {
+            pglBindBuffer(GL_ARRAY_BUFFER, bucket.vertexBuffer);
+            pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bucket.indexBuffer);
+        }
+        else {
+            base = reinterpret_cast<const char*>(bucket.vertices.data());
+            indices = bucket.indices.data();
+        }
+        glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), base + offsetof(MeshVertex, position));
+        glNormalPointer(GL_FLOAT, sizeof(MeshVertex), base + offsetof(MeshVertex, normal));
+        glTexCoordPointer(2, GL_FLOAT, sizeof(MeshVertex), base + offsetof(MeshVertex, texcoord));
+
+        ObjectGL::applyMaterial(bucket.material);
+        glDrawElements(GL_TRIANGLES, (GLsizei)bucket.indices.size(), GL_UNSIGNED_INT, indices);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    // ImGui draws from client side arrays, so no buffer may stay bound
+    if (hasBufferObjects()) {
+        pglBindBuffer(GL_ARRAY_BUFFER, 0);
+        pglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
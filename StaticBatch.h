@@ -0,0 +1,65 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "ObjectGL.h"
+
+using namespace std;
+
+// Objects that do not move, baked into world space and merged by material.
+// Every static object (ObjectGL::isStatic) added to the batch has its shapes transformed by the object
+// position, angle, scale and shape operations, and its full detail triangles appended to the bucket of
+// their material, so the whole set is drawn with one call per material and no matrix changes.
+// update() compares the placement of every object with the one it was baked with; when an object moved
+// only the buckets it was (or now is) part of are baked again.
+// Objects with callback operations can not be baked and keep drawing themselves.
+class StaticBatch {
+public:
+    StaticBatch() = default;
+    StaticBatch(const StaticBatch&) = delete; // owns opengl buffers
+    StaticBatch& operator=(const StaticBatch&) = delete;
+    ~StaticBatch();
+
+    bool add(ObjectGL* object); // bake a static object into the batch, false if it can not be baked
+    void update(); // bake again the buckets of the objects that moved, call once per frame before draw
+    void draw(); // draw every bucket in the view
+
+    size_t bucketCount() const { return this->buckets.size(); }
+    int bakes = 0; // the buckets baked since the batch was created
+
+private:
+    // the world transform, visibility and material of a shape when it was baked
+    struct ShapePlacement {
+        glm::mat4 world;
+        bool visible;
+        int materialOverride;
+    };
+
+    struct Entry {
+        ObjectGL* object;
+        vector<ShapePlacement> shapes;
+    };
+
+    // the triangles of every static shape range sharing one material
+    struct Bucket {
+        MeshMaterial material;
+        vector<MeshVertex> vertices;
+        vector<GLuint> indices;
+        MeshBounds bounds; // in world space
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        bool dirty = true;
+    };
+
+    vector<Entry> entries;
+    vector<Bucket> buckets;
+
+    static vector<ShapePlacement> placementOf(const ObjectGL& object);
+    static bool samePlacement(const vector<ShapePlacement>& a, const vector<ShapePlacement>& b);
+    static const MeshMaterial& materialOf(const ObjectGL& object, const DrawRange& range, int materialOverride);
+    int findBucket(const MeshMaterial& material, bool create); // the bucket of a material, -1 if there is none
+    void markBuckets(const Entry& entry); // mark dirty the buckets the shapes of an object go into
+    void bake(Bucket& bucket); // rebuild the triangles and buffers of a bucket from all the entries
+};
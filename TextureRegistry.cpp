@@ -0,0 +1,350 @@
+#include "TextureRegistry.h"
+#include "ObjectGL.h"
+#include "AssetLoader.h"
+#include "GLExtensions.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+TextureRegistry& TextureRegistry::instance() {
+    static TextureRegistry registry;
+    return registry;
+}
+
+string TextureRegistry::canonicalPath(string filename) {
+    if (!FileExists(filename)) {
+        // Append textures dir.
+        filename = TEXTURES_DIR + "/" + filename;
+    }
+
+    // remove "." and "dir/.." parts so every spelling of a path maps to the same texture
+    replace(filename.begin(), filename.end(), '\\', '/');
+    bool absolute = !filename.empty() && filename[0] == '/';
+    vector<string> parts;
+    stringstream stream(filename);
+    string part;
+    while (getline(stream, part, '/')) {
+        if (part.empty() || part == ".") {
+            continue;
+        }
+        if (part == ".." && !parts.empty() && parts.back() != "..") {
+            parts.pop_back();
+            continue;
+        }
+        parts.push_back(part);
+    }
+
+    string path = absolute ? "/" : "";
+    for (size_t i = 0; i < parts.size(); i++) {
+        path += (i > 0 ? "/" : "") + parts[i];
+    }
+#ifdef _WIN32
+    transform(path.begin(), path.end(), path.begin(), ::tolower); // windows paths are case insensitive
+#endif
+    return path;
+}
+
+DecodedTexture TextureRegistry::decode(const string& filename) {
+    string path = canonicalPath(filename);
+    shared_future<DecodedTexture> pending; // set when another thread already decoded the file
+    shared_ptr<promise<DecodedTexture>> decoded; // set when this thread decodes the file
+    {
+        lock_guard<mutex> lock(this->registryMutex);
+        map<string, Entry>::iterator entry = this->entries.find(path);
+        if (entry != this->entries.end() && entry->second.state != ENTRY_STREAMING) {
+            this->counters.decodeHits++;
+            DecodedTexture texture;
+            texture.filename = path; // already uploaded, acquire will only add a reference
+            return texture;
+        }
+        map<string, shared_future<DecodedTexture>>::iterator it = this->decoding.find(path);
+        if (it != this->decoding.end()) {
+            this->counters.decodeHits++;
+            pending = it->second;
+        }
+        else {
+            this->counters.decodeMisses++;
+            decoded = make_shared<promise<DecodedTexture>>();
+            this->decoding[path] = decoded->get_future().share();
+        }
+    }
+    if (pending.valid()) {
+        return pending.get();
+    }
+
+    DecodedTexture texture = decodeFile(path);
+    decoded->set_value(texture);
+    return texture;
+}
+
+DecodedTexture TextureRegistry::decodeFile(const string& path) {
+    DecodedTexture texture;
+    texture.filename = path;
+    if (!FileExists(path)) {
+        std::cerr << "Unable to find texture file: " << path << std::endl;
+        return texture;
+    }
+    std::cout << "Loading texture: " << path << std::endl;
+    unsigned char* image = stbi_load(path.c_str(), &texture.width, &texture.height, &texture.components, STBI_default);
+    if (!image) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return texture;
+    }
+    texture.pixels = shared_ptr<unsigned char>(image, stbi_image_free);
+    std::cout << "Texture details - Width: " << texture.width << ", Height: " << texture.height << ", Components: " << texture.components << std::endl;
+    return texture;
+}
+
+shared_future<DecodedTexture> TextureRegistry::decodeAsync(const string& path) {
+    map<string, shared_future<DecodedTexture>>::iterator it = this->decoding.find(path);
+    if (it != this->decoding.end()) {
+        this->counters.decodeHits++;
+        return it->second;
+    }
+    this->counters.decodeMisses++;
+    shared_ptr<promise<DecodedTexture>> decoded = make_shared<promise<DecodedTexture>>();
+    shared_future<DecodedTexture> image = decoded->get_future().share();
+    this->decoding[path] = image;
+    AssetLoader::instance().runAsync(path, "decode", [decoded, path]() { decoded->set_value(decodeFile(path)); });
+    return image;
+}
+
+GLuint TextureRegistry::acquire(const DecodedTexture& texture) {
+    lock_guard<mutex> lock(this->registryMutex);
+    map<string, Entry>::iterator it = this->entries.find(texture.filename);
+    if (it != this->entries.end()) {
+        this->counters.acquireHits++;
+        it->second.references++;
+        return it->second.id;
+    }
+    this->counters.acquireMisses++;
+    Entry entry = { createPlaceholder(), 1, 0, ENTRY_STREAMING };
+
+    if (this->streaming) {
+        // draw with the placeholder until update() uploaded the image
+        Upload upload;
+        upload.path = texture.filename;
+        upload.texture = entry.id;
+        if (texture.pixels) {
+            promise<DecodedTexture> decoded;
+            decoded.set_value(texture);
+            upload.image = decoded.get_future().share();
+        }
+        else {
+            upload.image = decodeAsync(texture.filename);
+        }
+        this->uploads.push_back(std::move(upload));
+        this->entries[texture.filename] = entry;
+        this->counters.streaming++;
+        return entry.id;
+    }
+
+    DecodedTexture image = texture;
+    if (!image.pixels) {
+        // the image may have been decoded by another request for the same file
+        map<string, shared_future<DecodedTexture>>::iterator pending = this->decoding.find(texture.filename);
+        image = pending != this->decoding.end() ? pending->second.get() : decodeFile(texture.filename);
+    }
+    this->decoding.erase(texture.filename); // the pixels are freed once every copy is gone
+
+    if (image.pixels) {
+        upload(entry.id, image, image.pixels.get());
+        entry.state = ENTRY_RESIDENT;
+        entry.bytes = (size_t)image.width * image.height * image.components;
+        this->counters.resident++;
+        this->counters.residentBytes += entry.bytes;
+    }
+    else {
+        std::cerr << "Using a placeholder for texture: " << texture.filename << std::endl;
+        entry.state = ENTRY_MISSING;
+        this->counters.missing++;
+    }
+    this->entries[texture.filename] = entry;
+    return entry.id;
+}
+
+GLuint TextureRegistry::acquire(const string& filename) {
+    if (this->streaming) {
+        DecodedTexture texture;
+        texture.filename = canonicalPath(filename); // decoded in the background
+        return acquire(texture);
+    }
+    return acquire(decode(filename));
+}
+
+void TextureRegistry::release(GLuint texture) {
+    lock_guard<mutex> lock(this->registryMutex);
+    for (map<string, Entry>::iterator it = this->entries.begin(); it != this->entries.end(); ++it) {
+        if (it->second.id != texture) {
+            continue;
+        }
+        if (--it->second.references == 0) {
+            glDeleteTextures(1, &it->second.id); // a streamed upload of it is dropped by update()
+            if (it->second.state == ENTRY_RESIDENT) {
+                this->counters.resident--;
+                this->counters.residentBytes -= it->second.bytes;
+            }
+            else if (it->second.state == ENTRY_STREAMING) {
+                this->counters.streaming--;
+            }
+            else {
+                this->counters.missing--;
+            }
+            this->entries.erase(it);
+        }
+        return;
+    }
+}
+
+void TextureRegistry::update() {
+    lock_guard<mutex> lock(this->registryMutex);
+    size_t budget = TEXTURE_UPLOAD_BUDGET;
+    list<Upload>::iterator it = this->uploads.begin();
+    while (it != this->uploads.end()) {
+        if (finishUpload(*it, budget)) {
+            it = this->uploads.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+bool TextureRegistry::finishUpload(Upload& upload, size_t& budget) {
+    map<string, Entry>::iterator entry = this->entries.find(upload.path);
+    bool released = entry == this->entries.end() || entry->second.id != upload.texture;
+
+    if (upload.pixelBuffer == 0) {
+        if (released) {
+            this->decoding.erase(upload.path); // or the decoded pixels would stay until the next acquire
+            return true;
+        }
+        if (upload.image.wait_for(chrono::seconds(0)) != future_status::ready) {
+            return false; // still decoding
+        }
+        upload.pixels = upload.image.get();
+        this->decoding.erase(upload.path);
+        if (!upload.pixels.pixels) {
+            std::cerr << "Using a placeholder for texture: " << upload.path << std::endl;
+            entry->second.state = ENTRY_MISSING;
+            this->counters.streaming--;
+            this->counters.missing++;
+            return true;
+        }
+        if (budget == 0) {
+            return false; // wait for the next frame
+        }
+
+        // map a pixel buffer and let a worker copy the pixels into it
+        size_t bytes = (size_t)upload.pixels.width * upload.pixels.height * upload.pixels.components;
+        void* mapped = NULL;
+        if (hasPixelBuffers()) {
+            pglGenBuffers(1, &upload.pixelBuffer);
+            pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pixelBuffer);
+            pglBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+            mapped = pglMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+            if (mapped == NULL) {
+                pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                pglDeleteBuffers(1, &upload.pixelBuffer);
+                upload.pixelBuffer = 0;
+            }
+            else {
+                pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            }
+        }
+        if (mapped == NULL) {
+            // no pixel buffers, upload straight from the decoded image
+            this->upload(upload.texture, upload.pixels, upload.pixels.pixels.get());
+        }
+        else {
+            shared_ptr<unsigned char> pixels = upload.pixels.pixels;
+            upload.copy = AssetLoader::instance().runAsync(upload.path, "stream", [mapped, pixels, bytes]() {
+                memcpy(mapped, pixels.get(), bytes);
+            });
+            return false;
+        }
+    }
+    else {
+        if (upload.copy.wait_for(chrono::seconds(0)) != future_status::ready) {
+            return false; // still copying
+        }
+        if (!released && budget == 0) {
+            return false; // wait for the next frame
+        }
+        pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pixelBuffer);
+        pglUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        if (!released) {
+            this->upload(upload.texture, upload.pixels, bufferOffset(0)); // read from the bound pixel buffer
+        }
+        pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pglDeleteBuffers(1, &upload.pixelBuffer);
+        if (released) {
+            return true;
+        }
+    }
+
+    entry->second.state = ENTRY_RESIDENT;
+    entry->second.bytes = (size_t)upload.pixels.width * upload.pixels.height * upload.pixels.components;
+    this->counters.streaming--;
+    this->counters.resident++;
+    this->counters.residentBytes += entry->second.bytes;
+    budget = entry->second.bytes >= budget ? 0 : budget - entry->second.bytes;
+    return true;
+}
+
+TextureStats TextureRegistry::stats() const {
+    lock_guard<mutex> lock(this->registryMutex);
+    return this->counters;
+}
+
+void TextureRegistry::printStats() const {
+    lock_guard<mutex> lock(this->registryMutex);
+    std::cout << "Textures: " << this->counters.resident << " resident ("
+        << std::fixed << std::setprecision(2) << this->counters.residentBytes / (1024.0 * 1024.0) << " MB), "
+        << std::defaultfloat << this->counters.streaming << " streaming, " << this->counters.missing << " missing" << std::endl;
+    std::cout << "  decode hits/misses: " << this->counters.decodeHits << "/" << this->counters.decodeMisses
+        << ", upload hits/misses: " << this->counters.acquireHits << "/" << this->counters.acquireMisses << std::endl;
+    for (const pair<const string, Entry>& entry : this->entries) {
+        std::cout << "  " << entry.first << " (id " << entry.second.id << ", " << entry.second.references << " references)" << std::endl;
+    }
+}
+
+GLuint TextureRegistry::createPlaceholder() {
+    const unsigned char grey[3] = { 204, 204, 204 }; // a single light grey texel
+
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    DecodedTexture placeholder;
+    placeholder.width = 1;
+    placeholder.height = 1;
+    placeholder.components = 3;
+    upload(texture_id, placeholder, grey);
+    return texture_id;
+}
+
+void TextureRegistry::upload(GLuint texture, const DecodedTexture& image, const GLvoid* pixels) {
+    int comp = image.components;
+    GLenum format = (comp == 1) ? GL_LUMINANCE : (comp == 2) ? GL_LUMINANCE_ALPHA : (comp == 3) ? GL_RGB : GL_RGBA;
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of rgb images are not padded to 4 bytes
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cerr << "OpenGL error after glTexImage2D: " << error << " (" << image.filename << ")" << std::endl;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <GL/glut.h>
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <future>
+
+using namespace std;
+
+// a texture image decoded on the cpu, waiting to be uploaded to opengl
+struct DecodedTexture {
+	string name; // the texture name used by the materials
+	string filename; // the canonical path of the file the image was read from
+	int width = 0;
+	int height = 0;
+	int components = 0;
+	shared_ptr<unsigned char> pixels; // the image data (null if the image could not be read or is already resident)
+};
+
+// how well the registry shares textures between objects
+struct TextureStats {
+	int decodeHits = 0; // decodes skipped because the file was already decoded or resident
+	int decodeMisses = 0; // files actually decoded
+	int acquireHits = 0; // acquires served by an already uploaded texture
+	int acquireMisses = 0; // textures uploaded to opengl
+	int resident = 0; // textures currently in opengl
+	size_t residentBytes = 0; // the size of the resident textures
+	int streaming = 0; // textures still drawn with the placeholder while they load
+	int missing = 0; // textures that could not be read and keep the placeholder
+};
+
+const size_t TEXTURE_UPLOAD_BUDGET = 4 * 1024 * 1024; // bytes of streamed textures uploaded per frame (at least one texture)
+
+// Process wide registry of the opengl textures, keyed by the canonical path of the texture file.
+// Every file is decoded and uploaded once however many objects or materials use it; objects acquire
+// the texture id and release it when they are destroyed, and the texture is deleted with its last user.
+//
+// In streaming mode acquire() never blocks: it returns a texture holding a placeholder image, the file is
+// decoded on the asset loader workers and update() copies the pixels into a pixel buffer on a worker and
+// then uploads them into the same texture id, so the objects never need to know the texture changed.
+// A texture that cannot be read keeps the placeholder.
+class TextureRegistry {
+public:
+	static TextureRegistry& instance();
+	static string canonicalPath(string filename); // the normalized path of a texture file, searching the textures directory
+
+	void setStreaming(bool enable) { streaming = enable; } // upload textures in the background instead of in acquire
+	DecodedTexture decode(const string& filename); // read a texture file into memory once (thread safe)
+	GLuint acquire(const DecodedTexture& texture); // upload the texture if it is not resident and add a reference (main thread)
+	GLuint acquire(const string& filename); // decode and acquire a texture file (main thread)
+	void release(GLuint texture); // remove a reference, deleting the texture when it was the last one
+	void update(); // continue the streamed uploads, call once per frame (main thread)
+
+	TextureStats stats() const;
+	void printStats() const; // log the hit/miss counters and the resident textures
+
+private:
+	enum EntryState { ENTRY_STREAMING, ENTRY_RESIDENT, ENTRY_MISSING };
+
+	struct Entry {
+		GLuint id;
+		int references;
+		size_t bytes;
+		EntryState state;
+	};
+
+	// a texture on its way from the file to opengl
+	struct Upload {
+		string path;
+		GLuint texture;
+		shared_future<DecodedTexture> image; // decoded on a worker
+		DecodedTexture pixels; // the decoded image once it is ready
+		GLuint pixelBuffer = 0; // mapped pixel buffer the pixels are copied into
+		future<void> copy; // the worker copy into the pixel buffer
+	};
+
+	TextureRegistry() = default;
+	static DecodedTexture decodeFile(const string& path); // stbi decode of a file
+	shared_future<DecodedTexture> decodeAsync(const string& path); // decode a file on a worker (called with the lock held)
+	static GLuint createPlaceholder(); // a new texture holding the placeholder image
+	static void upload(GLuint texture, const DecodedTexture& image, const GLvoid* pixels); // set the image of a texture
+	bool finishUpload(Upload& upload, size_t& budget); // advance a streamed upload, true when it is done
+
+	map<string, Entry> entries; // the acquired textures by canonical path
+	map<string, shared_future<DecodedTexture>> decoding; // decoded (or being decoded) images waiting for their upload
+	list<Upload> uploads; // the streamed uploads in progress
+	TextureStats counters;
+	bool streaming = false;
+	mutable mutex registryMutex;
+};
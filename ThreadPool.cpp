@@ -0,0 +1,45 @@
+#include "ThreadPool.h"
+
+static thread_local int workerIndex = -1; // the pool index of the current thread
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        unsigned int cores = thread::hardware_concurrency();
+        threadCount = cores > 2 ? cores - 1 : 1;
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        this->workers.push_back(thread(&ThreadPool::workerLoop, this, (int)i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(this->queueMutex);
+        this->stopping = true;
+    }
+    this->queueReady.notify_all();
+    for (thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::currentWorker() {
+    return workerIndex;
+}
+
+void ThreadPool::workerLoop(int index) {
+    workerIndex = index;
+    while (true) {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(this->queueMutex);
+            this->queueReady.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+            if (this->jobs.empty()) {
+                return; // stopping and nothing left to run
+            }
+            job = std::move(this->jobs.front());
+            this->jobs.pop();
+        }
+        job();
+    }
+}
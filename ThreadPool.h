@@ -0,0 +1,47 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <queue>
+#include <vector>
+
+using namespace std;
+
+// a fixed set of worker threads that run submitted jobs in submission order
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = 0); // 0 uses one thread per core, leaving one core to the main thread
+    ~ThreadPool(); // finishes the queued jobs and joins the workers
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // queue a job and get a future for its result
+    template <class Task>
+    future<typename result_of<Task()>::type> submit(Task task) {
+        typedef typename result_of<Task()>::type Result;
+        shared_ptr<packaged_task<Result()>> job = make_shared<packaged_task<Result()>>(task);
+        future<Result> result = job->get_future();
+        {
+            lock_guard<mutex> lock(this->queueMutex);
+            this->jobs.push([job]() { (*job)(); });
+        }
+        this->queueReady.notify_one();
+        return result;
+    }
+
+    unsigned int size() const { return (unsigned int)this->workers.size(); } // number of worker threads
+    static int currentWorker(); // index of the calling worker thread, -1 when not called from a pool worker
+
+private:
+    void workerLoop(int index);
+
+    vector<thread> workers;
+    queue<function<void()>> jobs;
+    mutex queueMutex;
+    condition_variable queueReady;
+    bool stopping = false;
+};
@@ -2,7 +2,7 @@
 #include "RandomColor.h"
 
 // Constructor for Walls
-// Initializes wall dimensions, color, and random seed
+// Initializes wall dimensions, and color
 Walls::Walls(GLfloat height, GLfloat xMin, GLfloat xMax, GLfloat yMin, GLfloat yMax, int rows, int columns) {
     // Set wall dimensions and position boundaries
     this->xMin = xMin;
@@ -13,9 +13,6 @@ Walls::Walls(GLfloat height, GLfloat xMin, GLfloat xMax, GLfloat yMin, GLfloat y
     this->rows = rows;
     this->columns = columns;
 
-    // Initialize the random seed for color generation
-    initRandomSeed();
-
     // Generate random colors for the walls
     generateWallColors();
 }
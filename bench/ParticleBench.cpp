@@ -0,0 +1,90 @@
+// Particle update benchmark: particles updated per millisecond by every kernel the cpu supports.
+//
+// Build (from the repository root):
+//   cl /O2 /EHsc bench\ParticleBench.cpp ParticleKernels.cpp
+//   g++ -O2 -std=c++14 bench/ParticleBench.cpp ParticleKernels.cpp -o particle_bench
+
+#include "../ParticleKernels.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+const size_t BENCH_SIZES[] = { 10000, 100000, 1000000 };
+const size_t BENCH_UPDATES = 200000000; // particle updates timed per kernel and size (spread over the frames)
+const float BENCH_DELTA_TIME = 0.016f;
+
+// the bubbles of the scene: spawned around the machine, long lived
+struct BubbleStreams {
+    vector<float> posX, posY, posZ, velX, velY, velZ, life, size;
+
+    explicit BubbleStreams(size_t count) {
+        mt19937 random(1234);
+        uniform_real_distribution<float> unit(0.0f, 1.0f);
+        vector<float>* streams[] = { &posX, &posY, &posZ, &velX, &velY, &velZ, &life, &size };
+        for (vector<float>* stream : streams) {
+            stream->resize(count);
+        }
+        for (size_t i = 0; i < count; i++) {
+            posX[i] = (unit(random) - 0.5f) * 16.0f;
+            posY[i] = 2.0f + unit(random) * 8.0f;
+            posZ[i] = (unit(random) - 0.5f) * 16.0f;
+            velX[i] = (unit(random) - 0.5f) * 5.0f;
+            velY[i] = unit(random) * 2.0f + 3.0f;
+            velZ[i] = (unit(random) - 0.5f) * 5.0f;
+            life[i] = 10.0f;
+            size[i] = unit(random) * 0.1f + 0.2f;
+        }
+    }
+
+    ParticleStreams streams() {
+        ParticleStreams s = { posX.data(), posY.data(), posZ.data(), velX.data(), velY.data(), velZ.data(),
+            life.data(), size.data() };
+        return s;
+    }
+};
+
+int main() {
+    // the room is large enough that the particles stay inside for the whole run
+    const ParticleBounds bounds = { { -1.0e6f, -1.0e6f, -1.0e6f }, { 1.0e6f, 1.0e6f, 1.0e6f } };
+
+    vector<ParticleKernel> kernels;
+    kernels.push_back(PARTICLE_KERNEL_SCALAR);
+    if (bestParticleKernel() >= PARTICLE_KERNEL_SSE) {
+        kernels.push_back(PARTICLE_KERNEL_SSE);
+    }
+    if (bestParticleKernel() >= PARTICLE_KERNEL_AVX2) {
+        kernels.push_back(PARTICLE_KERNEL_AVX2);
+    }
+
+    printf("%10s %8s %16s %10s\n", "particles", "kernel", "particles/ms", "speedup");
+    for (size_t count : BENCH_SIZES) {
+        size_t frames = BENCH_UPDATES / count;
+        double scalarRate = 0;
+        vector<float> reference;
+        for (ParticleKernel kernel : kernels) {
+            BubbleStreams bubbles(count);
+            ParticleStreams streams = bubbles.streams();
+            updateParticles(streams, 0, count, bounds, BENCH_DELTA_TIME, kernel); // warm the caches
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (size_t frame = 0; frame < frames; frame++) {
+                updateParticles(streams, 0, count, bounds, BENCH_DELTA_TIME, kernel);
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            double rate = count * frames / ms;
+            if (kernel == PARTICLE_KERNEL_SCALAR) {
+                scalarRate = rate;
+                reference = bubbles.posY;
+            }
+            bool same = bubbles.posY.size() == reference.size() &&
+                memcmp(bubbles.posY.data(), reference.data(), reference.size() * sizeof(float)) == 0;
+            printf("%10zu %8s %16.0f %9.2fx%s\n", count, particleKernelName(kernel), rate, rate / scalarRate,
+                same ? "" : "  (results differ from scalar)");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Bubble contact benchmark: the pairs of touching bubbles found with the uniform grid against testing every pair.
+// Also checks that both find the same pairs.
+//
+// Build (from the repository root):
+//   cl /O2 /EHsc bench\ParticleGridBench.cpp ParticleGrid.cpp
+//   g++ -O2 -std=c++14 bench/ParticleGridBench.cpp ParticleGrid.cpp -o particle_grid_bench
+
+#include "../ParticleGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+const size_t GRID_SIZES[] = { 1000, 4000, 16000, 64000, 256000 };
+const size_t GRID_BRUTE_FORCE_LIMIT = 64000; // more bubbles take too long to test every pair
+const double GRID_MIN_MS = 200; // repeat a measure until it took this long
+const ParticleBounds GRID_BOUNDS = { { -12.0f, 0.0f, -12.0f }, { 12.0f, 12.0f, 12.0f } }; // the club
+
+// bubbles spread over the club, sized like the ones of the machines
+struct Bubbles {
+    vector<float> x, y, z, radius;
+
+    explicit Bubbles(size_t count) {
+        mt19937 random(1234);
+        uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (size_t i = 0; i < count; i++) {
+            x.push_back(GRID_BOUNDS.lower[0] + unit(random) * 24.0f);
+            y.push_back(GRID_BOUNDS.lower[1] + unit(random) * 12.0f);
+            z.push_back(GRID_BOUNDS.lower[2] + unit(random) * 24.0f);
+            radius.push_back((unit(random) * 0.1f + 0.2f) * 0.5f);
+        }
+    }
+};
+
+static vector<pair<uint32_t, uint32_t>> bruteForce(const Bubbles& b) {
+    vector<pair<uint32_t, uint32_t>> pairs;
+    size_t count = b.x.size();
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = i + 1; j < count; j++) {
+            float dx = b.x[i] - b.x[j], dy = b.y[i] - b.y[j], dz = b.z[i] - b.z[j];
+            float contact = b.radius[i] + b.radius[j];
+            if (dx * dx + dy * dy + dz * dz < contact * contact) {
+                pairs.push_back(make_pair(i, j));
+            }
+        }
+    }
+    return pairs;
+}
+
+static vector<pair<uint32_t, uint32_t>> withGrid(const Bubbles& b, ParticleGrid& grid) {
+    vector<pair<uint32_t, uint32_t>> pairs;
+    grid.build(b.x.data(), b.y.data(), b.z.data(), b.x.size(), GRID_BOUNDS, 0.3f);
+    grid.forEachPair([&b](uint32_t i) { return b.radius[i]; },
+        [&pairs](uint32_t i, uint32_t j, float) { pairs.push_back(make_pair(i, j)); });
+    return pairs;
+}
+
+// the milliseconds of one run of a search, repeated to get a stable time
+template <typename Search>
+static double measure(Search search, vector<pair<uint32_t, uint32_t>>& pairs) {
+    int runs = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double ms = 0;
+    do {
+        pairs = search();
+        runs++;
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } while (ms < GRID_MIN_MS);
+    return ms / runs;
+}
+
+int main() {
+    printf("%10s %10s %14s %14s %10s\n", "bubbles", "contacts", "brute ms", "grid ms", "speedup");
+    ParticleGrid grid;
+    for (size_t count : GRID_SIZES) {
+        Bubbles bubbles(count);
+        vector<pair<uint32_t, uint32_t>> gridPairs, brutePairs;
+        double gridMs = measure([&]() { return withGrid(bubbles, grid); }, gridPairs);
+        if (count > GRID_BRUTE_FORCE_LIMIT) {
+            printf("%10zu %10zu %14s %14.3f %10s\n", count, gridPairs.size(), "-", gridMs, "-");
+            continue;
+        }
+        double bruteMs = measure([&]() { return bruteForce(bubbles); }, brutePairs);
+        sort(gridPairs.begin(), gridPairs.end());
+        bool same = gridPairs == brutePairs;
+        printf("%10zu %10zu %14.3f %14.3f %9.1fx%s\n", count, gridPairs.size(), bruteMs, gridMs, bruteMs / gridMs,
+            same ? "" : "  (the grid missed or added pairs)");
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Parallel particle update benchmark: time per update of ParticleSystem for 1 to N threads.
+// Also checks that every thread count gives exactly the particles of the single threaded update.
+// The largest thread count is the number of cores, or the first argument.
+//
+// Build (from the repository root):
+//   cl /O2 /EHsc /I. bench\ParticleScalingBench.cpp ParticleKernels.cpp ParticleGrid.cpp ThreadPool.cpp Random.cpp
+//   g++ -O2 -std=c++14 -pthread -I. bench/ParticleScalingBench.cpp ParticleKernels.cpp ParticleGrid.cpp ThreadPool.cpp Random.cpp -o particle_scaling
+
+#include "ParticleSystem.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const size_t SCALING_SIZES[] = { 100000, 1000000 };
+const size_t SCALING_UPDATES = 100000000; // particle updates timed per size and thread count
+const float SCALING_DELTA_TIME = 0.016f;
+
+// a full system of bubbles spread over the club
+static void fill(ParticleSystem& particles, size_t count) {
+    mt19937 random(1234);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    particles.setCapacity(count);
+    particles.setBounds(glm::vec3(-12.0f, 0.0f, -12.0f), glm::vec3(12.0f, 12.0f, 12.0f));
+    particles.contact = PARTICLE_PASS_THROUGH; // only the parallel update is measured
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 position((unit(random) - 0.5f) * 16.0f, 2.0f + unit(random) * 8.0f, (unit(random) - 0.5f) * 16.0f);
+        glm::vec3 velocity((unit(random) - 0.5f) * 0.5f, unit(random) * 0.2f, (unit(random) - 0.5f) * 0.5f);
+        particles.addParticle(Particle(position, velocity, glm::vec4(1.0f), 1000.0f, unit(random) * 0.1f + 0.2f));
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned int maxThreads = argc > 1 ? (unsigned int)atoi(argv[1]) : thread::hardware_concurrency();
+    maxThreads = max(maxThreads, 1u);
+    printf("%10s %8s %14s %10s %11s\n", "particles", "threads", "ms/update", "speedup", "efficiency");
+    for (size_t count : SCALING_SIZES) {
+        size_t frames = SCALING_UPDATES / count;
+        double single = 0;
+        vector<float> reference;
+        for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+            // the calling thread works too, so n threads is a pool of n - 1 workers
+            unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : NULL);
+            ParticleSystem particles;
+            fill(particles, count);
+            particles.pool = pool.get();
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (size_t frame = 0; frame < frames; frame++) {
+                particles.update(SCALING_DELTA_TIME);
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / frames;
+
+            vector<float> state(particles.posY.begin(), particles.posY.begin() + particles.count());
+            if (threads == 1) {
+                single = ms;
+                reference = state;
+            }
+            bool same = state.size() == reference.size() &&
+                memcmp(state.data(), reference.data(), state.size() * sizeof(float)) == 0;
+            printf("%10zu %8u %14.3f %9.2fx %10.0f%%%s\n", count, threads, ms, single / ms, 100.0 * single / ms / threads,
+                same ? "" : "  (results differ from 1 thread)");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Robot crowd benchmark: the time to animate and pose N dancing robots, one Robot-style skeleton at a time
+// against the crowd's vector loops, for every kernel the processor supports.
+// Also checks that the kernels agree and that the crowd poses a robot like its skeleton would.
+// The drawing is timed in the application: the "crowd draw" line of the debug window.
+//
+// Build (from the repository root):
+//   cl /O2 /EHsc /I. bench\RobotCrowdBench.cpp RobotCrowd.cpp RobotRig.cpp Skeleton.cpp Random.cpp ParticleKernels.cpp ThreadPool.cpp
+//   g++ -O2 -std=c++14 -pthread -I. bench/RobotCrowdBench.cpp RobotCrowd.cpp RobotRig.cpp Skeleton.cpp Random.cpp ParticleKernels.cpp ThreadPool.cpp -o robot_crowd_bench
+
+#include "../RobotCrowd.h"
+#include "../ThreadPool.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+
+const size_t CROWD_SIZES[] = { 250, 1000, 2500, 5000, 10000 };
+const double CROWD_MIN_MS = 200; // repeat a measure until it took this long
+const glm::vec2 CROWD_FLOOR_LOWER(-11.0f), CROWD_FLOOR_UPPER(11.0f); // the floor of the club
+
+// the milliseconds of one frame of a crowd, repeated to get a stable time
+template <typename Frame>
+static double measure(Frame frame) {
+    int runs = 0;
+    float time = 0.0f;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double ms = 0;
+    do {
+        frame(time);
+        time += 40.0f / 60.0f; // the dance time of a frame at 60 Hz
+        runs++;
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    } while (ms < CROWD_MIN_MS);
+    return ms / runs;
+}
+
+// Robot::dance on a skeleton per robot, the way the single robot is animated
+static void danceOneByOne(vector<Skeleton>& skeletons, const vector<float>& phases, float time) {
+    for (size_t i = 0; i < skeletons.size(); i++) {
+        Skeleton& s = skeletons[i];
+        float t = time + phases[i];
+        s.setAngle(ROBOT_HEAD_TURN, 15.0f * sinf(t * 2.0f));
+        s.setAngle(ROBOT_HEAD_NOD, 10.0f * sinf(t * 3.0f));
+        s.setAngle(ROBOT_LEFT_SHOULDER, 45.0f + 30.0f * sinf(t * 2.5f));
+        s.setAngle(ROBOT_RIGHT_SHOULDER, 45.0f + 30.0f * sinf(t * 2.5f + 3.14159265f));
+        s.setAngle(ROBOT_LEFT_ELBOW, 20.0f + 20.0f * sinf(t * 3.5f));
+        s.setAngle(ROBOT_RIGHT_ELBOW, 20.0f + 20.0f * sinf(t * 3.5f + 3.14159265f));
+        s.setAngle(ROBOT_LEFT_HIP, 10.0f * sinf(t * 2.0f));
+        s.setAngle(ROBOT_RIGHT_HIP, -10.0f * sinf(t * 2.0f));
+        s.setAngle(ROBOT_ROOT, 10.0f * sinf(t * 1.5f));
+        s.update();
+    }
+}
+
+// the largest difference between the angles of two kernels, in degrees
+static float kernelDifference(RobotCrowd& a, RobotCrowd& b, ParticleKernel kernel, float time) {
+    a.animate(time, PARTICLE_KERNEL_SCALAR);
+    b.animate(time, kernel);
+    float worst = 0.0f;
+    for (int c = 0; c < CROWD_CHANNELS; c++) {
+        for (size_t i = 0; i < a.size(); i++) {
+            worst = max(worst, fabsf(a.angle((CrowdChannel)c, i) - b.angle((CrowdChannel)c, i)));
+        }
+    }
+    return worst;
+}
+
+// the largest difference between the joint matrices of the crowd and of skeletons given the same angles
+static float poseDifference() {
+    RobotCrowd crowd;
+    crowd.populate(64, glm::vec2(-15.0f), glm::vec2(15.0f)); // roomy enough for full size robots
+    crowd.animate(123.0f, bestParticleKernel());
+    crowd.pose(NULL);
+    const CrowdChannel channels[] = { CROWD_ROOT, CROWD_HEAD_TURN, CROWD_HEAD_NOD, CROWD_LEFT_SHOULDER, CROWD_RIGHT_SHOULDER,
+        CROWD_LEFT_ELBOW, CROWD_RIGHT_ELBOW, CROWD_LEFT_HIP, CROWD_RIGHT_HIP };
+    const RobotJoint joints[] = { ROBOT_ROOT, ROBOT_HEAD_TURN, ROBOT_HEAD_NOD, ROBOT_LEFT_SHOULDER, ROBOT_RIGHT_SHOULDER,
+        ROBOT_LEFT_ELBOW, ROBOT_RIGHT_ELBOW, ROBOT_LEFT_HIP, ROBOT_RIGHT_HIP };
+    float worst = 0.0f;
+    for (size_t i = 0; i < crowd.size(); i++) {
+        Skeleton skeleton;
+        buildRobotSkeleton(skeleton);
+        skeleton.setOffset(ROBOT_ROOT, crowd.position(i) + glm::vec3(0.0f, 1.0f, 0.0f));
+        for (int c = 0; c < CROWD_CHANNELS; c++) {
+            skeleton.setAngle(joints[c], crowd.angle(channels[c], i));
+        }
+        skeleton.update();
+        for (int j = 0; j < ROBOT_JOINTS; j++) {
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 4; row++) {
+                    worst = max(worst, fabsf(skeleton.world(j)[column][row] - crowd.joints(i)[j][column][row]));
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+int main() {
+    ThreadPool pool;
+    vector<ParticleKernel> kernels = { PARTICLE_KERNEL_SCALAR };
+    if (bestParticleKernel() != PARTICLE_KERNEL_SCALAR) {
+        kernels.push_back(PARTICLE_KERNEL_SSE);
+    }
+    if (bestParticleKernel() == PARTICLE_KERNEL_AVX2) {
+        kernels.push_back(PARTICLE_KERNEL_AVX2);
+    }
+
+    printf("crowd pose against skeletons: %.2g apart\n", poseDifference());
+    printf("%8s %14s", "robots", "one by one ms");
+    for (ParticleKernel kernel : kernels) {
+        printf(" %10s ms", particleKernelName(kernel));
+    }
+    printf(" %12s %12s %10s\n", "pose ms", "pose pool ms", "speedup");
+    for (size_t count : CROWD_SIZES) {
+        vector<Skeleton> skeletons(count);
+        vector<float> phases;
+        for (size_t i = 0; i < count; i++) {
+            buildRobotSkeleton(skeletons[i]);
+            phases.push_back(0.37f * i);
+        }
+        double oneByOne = measure([&](float time) { danceOneByOne(skeletons, phases, time); });
+        printf("%8zu %14.3f", count, oneByOne);
+
+        RobotCrowd crowd, reference;
+        crowd.populate(count, CROWD_FLOOR_LOWER, CROWD_FLOOR_UPPER);
+        reference.populate(count, CROWD_FLOOR_LOWER, CROWD_FLOOR_UPPER);
+        double best = 0;
+        float worstAngle = 0.0f;
+        for (ParticleKernel kernel : kernels) {
+            double ms = measure([&](float time) { crowd.animate(time, kernel); });
+            printf(" %13.3f", ms);
+            best = ms;
+            worstAngle = max(worstAngle, kernelDifference(reference, crowd, kernel, 987.0f));
+        }
+        double pose = measure([&](float) { crowd.pose(NULL); });
+        double posePool = measure([&](float) { crowd.pose(&pool); });
+        printf(" %12.3f %12.3f %9.1fx%s\n", pose, posePool, oneByOne / (best + posePool),
+            worstAngle < 1e-3f ? "" : "  (the kernels disagree)");
+    }
+    return 0;
+}